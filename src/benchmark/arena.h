@@ -0,0 +1,117 @@
+#pragma once
+
+#include <jemalloc/jemalloc.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A jemalloc arena of its own for one index instance (--memory). Threads move to it for the
+// duration of an ArenaScope, so whatever the index allocates from them is accounted to the
+// arena, whether or not the index implements memory_consumption().
+//
+// jemalloc can only destroy an arena whose every allocation is dead, and an index may leave
+// behind objects that stay reachable (Masstree links its threadinfos into a global list), so an
+// arena is not destroyed but purged and handed to the next index instance. The statistics count
+// from what the arena held when it was taken.
+class IndexArena {
+public:
+    struct Stats {
+        long long allocated = 0;  // bytes handed out by malloc and not freed
+        long long active = 0;  // bytes of the pages holding them
+        long long resident = 0;  // bytes of the arena that are resident, metadata included
+    };
+
+    IndexArena() {
+        if (!free_arenas().empty()) {
+            id = free_arenas().back();
+            free_arenas().pop_back();
+            created = true;
+        } else {
+            size_t size = sizeof(id);
+            created = mallctl("arenas.create", &id, &size, nullptr, 0) == 0;
+        }
+        if (created) baseline = current();
+    }
+
+    // the objects the index freed from this thread go back to the arena before its unused pages
+    // are given back
+    ~IndexArena() {
+        if (!created) return;
+        mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+        mallctl(("arena." + std::to_string(id) + ".purge").c_str(), nullptr, nullptr, nullptr, 0);
+        free_arenas().push_back(id);
+    }
+
+    IndexArena(const IndexArena &) = delete;
+    IndexArena &operator=(const IndexArena &) = delete;
+
+    bool ok() const { return created; }
+
+    unsigned arena_id() const { return id; }
+
+    Stats stats() const {
+        Stats stats = current();
+        stats.allocated -= baseline.allocated;
+        stats.active -= baseline.active;
+        stats.resident -= baseline.resident;
+        return stats;
+    }
+
+private:
+    Stats current() const {
+        Stats stats;
+        if (!created) return stats;
+        uint64_t epoch = 1;
+        size_t size = sizeof(epoch);
+        mallctl("epoch", &epoch, &size, &epoch, size);  // refresh the statistics
+        std::string prefix = "stats.arenas." + std::to_string(id) + ".";
+        stats.allocated = read(prefix + "small.allocated") + read(prefix + "large.allocated");
+        stats.active = read(prefix + "pactive") * read("arenas.page");
+        stats.resident = read(prefix + "resident");
+        return stats;
+    }
+
+    // arenas of index instances that are gone, to be reused
+    static std::vector<unsigned> &free_arenas() {
+        static std::vector<unsigned> arenas;
+        return arenas;
+    }
+
+    static long long read(const std::string &name) {
+        size_t value = 0;
+        size_t size = sizeof(value);
+        if (mallctl(name.c_str(), &value, &size, nullptr, 0) != 0) return 0;
+        return value;
+    }
+
+    unsigned id = 0;
+    bool created = false;
+    Stats baseline;
+};
+
+// Moves the calling thread to an arena until the end of the scope (no-op without one). The
+// thread cache is flushed on the way in and out, so the index neither gets objects cached from
+// the previous arena nor leaves its own behind in the cache.
+class ArenaScope {
+public:
+    explicit ArenaScope(const IndexArena *arena) {
+        if (!arena || !arena->ok()) return;
+        unsigned id = arena->arena_id();
+        size_t size = sizeof(previous);
+        mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+        active = mallctl("thread.arena", &previous, &size, &id, sizeof(id)) == 0;
+    }
+
+    ~ArenaScope() {
+        if (!active) return;
+        mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+        mallctl("thread.arena", nullptr, nullptr, &previous, sizeof(previous));
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    unsigned previous = 0;
+    bool active = false;
+};
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <algorithm>
 #include <atomic>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
@@ -13,12 +14,20 @@
 #include <fstream>
 #include <thread>
 #include <ctime>
+#include <chrono>
 
 #include "../tscns.h"
 #include "omp.h"
 #include "tbb/parallel_sort.h"
 #include "flags.h"
 #include "utils.h"
+#include "histogram.h"
+#include "perf_counter.h"
+#include "topology.h"
+#include "trace.h"
+#include "payload.h"
+#include "sampler.h"
+#include "arena.h"
 #include "../competitor/competitor.h"
 #include "../competitor/indexInterface.h"
 #include "pgm_metric.h"
@@ -29,7 +38,27 @@ class Benchmark {
     typedef indexInterface <KEY_TYPE, PAYLOAD_TYPE> index_t;
 
     enum Operation {
-        READ = 0, INSERT, DELETE, SCAN, UPDATE
+        READ = 0, INSERT, DELETE, SCAN, UPDATE, RMW, OPERATION_NUM
+    };
+    static constexpr const char *operation_names[OPERATION_NUM] = {"read", "insert", "delete", "scan", "update", "rmw"};
+
+    // One phase of a --workload: its own operation mix, key distribution, length and threads.
+    // A phase ends after operations_num operations, or after seconds when that is set.
+    struct Phase {
+        std::string name;
+        double read_ratio = 0;
+        double insert_ratio = 0;
+        double delete_ratio = 0;
+        double update_ratio = 0;
+        double scan_ratio = 0;
+        double rmw_ratio = 0;
+        std::string sample_distribution;
+        double zipf_theta = 0.99;
+        double hotspot_keys = 0.2;
+        double hotspot_ops = 0.8;
+        size_t operations_num = 0;
+        double seconds = 0;
+        size_t thread_num = 0;  // 0: the --thread_num being swept
     };
 
     // parameters
@@ -38,8 +67,12 @@ class Benchmark {
     double delete_ratio = 0;
     double update_ratio = 0;
     double scan_ratio = 0;
+    double rmw_ratio = 0;
     size_t scan_num = 100;
+    size_t max_scan_num = 100;  // scan buffer size, at least the longest scan of a replayed trace
+    size_t verify_scan = 0;
     size_t operations_num;
+    bool operations_num_given = false;  // --operations_num was passed, not its default
     long long table_size = -1;
     size_t init_table_size;
     double init_table_ratio;
@@ -50,38 +83,121 @@ class Benchmark {
     std::string index_type;
     std::string keys_file_path;
     std::string keys_file_type;
+    std::string key_type = "u64";  // name of KEY_TYPE, chosen in main
+    std::string string_encoding;
+    size_t payload_size = 8;  // sizeof(PAYLOAD_TYPE), chosen in main
+    size_t blob_size = 0;  // > 0: values are blobs of this size, the payload is their address
+    std::vector<std::unique_ptr<ValueArena>> value_arenas;  // per worker, live as long as the index
     std::string sample_distribution;
+    double zipf_theta = 0.99;
+    double hotspot_keys = 0.2;
+    double hotspot_ops = 0.8;
+    KeyDistribution distribution;  // of the current phase
+    std::map<std::pair<size_t, double>, double> zeta_cache;  // zeta(keys, theta)
     bool latency_sample = false;
     double latency_sample_ratio = 0.01;
     int error_bound;
     std::string output_path;
     size_t random_seed;
     bool memory_record;
+    std::unique_ptr<IndexArena> index_arena;  // with --memory, of the current index
+    size_t index_keys = 0;  // keys in the current index before the running phase
     bool dataset_statistic;
     bool data_shift = false;
+    bool key_cache = false;
+    bool op_stream = false;
+    std::string schedule;
+    size_t chunk_size = 10000;
+    std::vector <std::string> all_target_qps;
+    double target_qps = 0;
+    std::string arrival;
+    size_t timeline_interval = 0;
+    std::string timeline_path;
+    std::string run_id;
+    bool perf = false;
+    bool bulkload_only = false;
+    size_t batch_size = 1;
+    size_t interleave = 0;
+    bool virtual_dispatch = false;
+    std::string pin;
+    std::string numa;
+    Topology topology;
+    std::vector<int> pin_cpus;
+    bool numa_active = false;
+    size_t warmup_ops = 0;
+    double warmup_seconds = 0;
+    size_t repeat = 1;
+    size_t trial = 1;
+    std::string workload;
+    std::vector<Phase> phases;
+    size_t phase_id = 0;
+    double phase_seconds = 0;
+    std::vector<std::vector<double>> trial_throughput;  // per phase
+    // next unused insert / delete key, carried from one phase to the next
+    size_t insert_cursor = 0;
+    size_t delete_cursor = 0;
 
     std::vector <KEY_TYPE> init_keys;
     KEY_TYPE *keys;
     std::pair <KEY_TYPE, PAYLOAD_TYPE> *init_key_values;
-    std::vector <std::pair<Operation, KEY_TYPE>> operations;
+    typedef TraceRecord<KEY_TYPE> operation_t;
+    std::vector <operation_t> operations;
+    // the operations the workers run: operations, or the records of a mapped --replay_trace
+    const operation_t *operation_data = nullptr;
+    std::unique_ptr<MappedFile> trace_file;
+    std::string record_trace;
+    std::string replay_trace;
+    std::vector<bool> trace_recorded;  // per phase
+    size_t replay_op_num[OPERATION_NUM] = {};  // operations of each type in the --replay_trace
     std::mt19937 gen;
 
     struct Stat {
-        std::vector<double> latency;
+        // latency in tsc ticks, tsc_ns converts them to nanoseconds
+        LatencyHistogram latency;
+        LatencyHistogram op_latency[OPERATION_NUM];
+        double tsc_ns = 1;
         uint64_t throughput = 0;
+        uint64_t operations = 0;
+        double bulk_load_time = 0;  // s
+        uint64_t bulk_load_throughput = 0;  // keys/s
+        long long bulk_load_memory = 0;  // peak RSS growth, bytes
         size_t fitness_of_dataset = 0;
         long long memory_consumption = 0;
+        IndexArena::Stats arena;  // of the index arena, with --memory
+        long long peak_rss = 0;  // VmHWM of the run, bytes
+        long long peak_arena_allocated = 0;  // the most arena bytes sampled by the timeline
         uint64_t success_insert = 0;
         uint64_t success_read = 0;
         uint64_t success_update = 0;
         uint64_t success_remove = 0;
         uint64_t scan_not_enough = 0;
+        std::vector<double> thread_time;
+        // hardware events of the bulk load, the whole run, and the sampled operations of every type
+        PerfCounters::Values bulk_load_perf;
+        PerfCounters::Values run_perf;
+        PerfCounters::Values op_perf[OPERATION_NUM];
+        uint64_t op_perf_count[OPERATION_NUM] = {0};
 
         void clear() {
             latency.clear();
+            for (auto &h : op_latency) h.clear();
+            thread_time.clear();
+            bulk_load_perf = PerfCounters::Values();
+            run_perf = PerfCounters::Values();
+            for (int op = 0; op < OPERATION_NUM; op++) {
+                op_perf[op] = PerfCounters::Values();
+                op_perf_count[op] = 0;
+            }
             throughput = 0;
+            operations = 0;
+            bulk_load_time = 0;
+            bulk_load_throughput = 0;
+            bulk_load_memory = 0;
             fitness_of_dataset = 0;
             memory_consumption = 0;
+            arena = IndexArena::Stats();
+            peak_rss = 0;
+            peak_arena_allocated = 0;
             success_insert = 0;
             success_read = 0;
             success_update = 0;
@@ -92,47 +208,196 @@ class Benchmark {
 
     struct alignas(CACHELINE_SIZE)
     ThreadParam {
-        std::vector<std::pair<uint64_t, uint64_t>> latency;
-        uint64_t success_insert = 0;
+        LatencyHistogram latency[OPERATION_NUM];
+        // only written by the owning worker, read by the timeline sampler
+        std::atomic<uint64_t> operations{0};
+        Relaxed<uint64_t> success_insert = 0;
         uint64_t success_read = 0;
         uint64_t success_update = 0;
-        uint64_t success_remove = 0;
+        Relaxed<uint64_t> success_remove = 0;
         uint64_t scan_not_enough = 0;
+        int64_t finish_time = 0;
+        size_t insert_position = 0;  // --op_stream: the first insert / delete key left unused
+        size_t delete_position = 0;
+        PerfCounters::Values run_perf;
+        PerfCounters::Values op_perf[OPERATION_NUM];
+        uint64_t op_perf_count[OPERATION_NUM] = {0};
+        uint64_t blob_checksum = 0;  // keeps the blob reads from being optimized away
     };
     typedef ThreadParam param_t;
-public:
-    Benchmark() {
-    }
 
-    KEY_TYPE *load_keys() {
-        // Read keys from file
-        COUT_THIS("Reading data from file.");
+    // One point of the time series taken every timeline_interval ms during run()
+    struct TimelineSample {
+        int64_t time;  // ns
+        uint64_t operations;
+        LatencyHistogram latency;  // latency of the operations finished since the previous sample
+        size_t keys;  // in the index
+        long long rss;  // bytes
+        IndexArena::Stats arena;  // with --memory
+    };
+    std::vector<TimelineSample> timeline;
+
+    // Per-thread operation source for --op_stream. It draws the same operation mix as
+    // generate_operations, but on the fly and seeded per thread, so nothing is materialized.
+    // Every thread inserts and deletes from its own slice of the key array.
+    class OperationStream {
+    public:
+        OperationStream(const Benchmark &bench, size_t thread_id, size_t thread_num)
+                : bench(bench), rng(bench.random_seed * 0x9E3779B97F4A7C15ull + thread_id + 1),
+                  sampler(bench.distribution, splitmix64(rng), bench.init_table_size * thread_id / thread_num) {
+            size_t ops_begin = bench.operations_num * thread_id / thread_num;
+            remaining = bench.operations_num * (thread_id + 1) / thread_num - ops_begin;
+            size_t insert_keys = bench.table_size - bench.insert_cursor;
+            insert_cursor = bench.insert_cursor + insert_keys * thread_id / thread_num;
+            insert_end = bench.insert_cursor + insert_keys * (thread_id + 1) / thread_num;
+            size_t delete_keys = bench.table_size - bench.delete_cursor;
+            delete_cursor = bench.delete_cursor + delete_keys * thread_id / thread_num;
+            delete_end = bench.delete_cursor + delete_keys * (thread_id + 1) / thread_num;
+            insert_begin = insert_cursor;
+        }
+
+        // Returns false once the thread's share of operations (or of insert/delete keys) is used up
+        inline bool next(Operation &op, KEY_TYPE &key) {
+            if (remaining == 0) return false;
+            remaining--;
+            double prob = (next_random() >> 11) * 0x1.0p-53;
+            if (prob < bench.read_ratio) {
+                op = READ;
+                key = sample_key();
+            } else if (prob < bench.read_ratio + bench.insert_ratio) {
+                if (insert_cursor >= insert_end) return false;
+                op = INSERT;
+                key = bench.keys[insert_cursor++];
+            } else if (prob < bench.read_ratio + bench.insert_ratio + bench.update_ratio) {
+                op = UPDATE;
+                key = sample_key();
+            } else if (prob < bench.read_ratio + bench.insert_ratio + bench.update_ratio + bench.scan_ratio) {
+                op = SCAN;
+                key = sample_key();
+            } else if (prob < bench.read_ratio + bench.insert_ratio + bench.update_ratio + bench.scan_ratio +
+                              bench.rmw_ratio) {
+                op = RMW;
+                key = sample_key();
+            } else {
+                if (delete_cursor >= delete_end) return false;
+                op = DELETE;
+                key = bench.keys[delete_cursor++];
+            }
+            return true;
+        }
 
-        if (table_size > 0) keys = new KEY_TYPE[table_size];
+        // the first insert / delete key this thread did not use
+        size_t insert_position() const { return insert_cursor; }
 
+        size_t delete_position() const { return delete_cursor; }
 
+    private:
+        inline uint64_t next_random() { return splitmix64(rng); }
+
+        // Latest counts back over this thread's own inserts, then over the keys that were there
+        // before the phase, skipping the slices of the other threads
+        inline KEY_TYPE sample_key() {
+            size_t pos = sampler.next();
+            if (bench.distribution.kind != KeyDistribution::LATEST) return bench.init_keys[pos];
+            size_t own = insert_cursor - insert_begin;
+            return bench.keys[pos < own ? insert_cursor - 1 - pos : bench.insert_cursor - 1 - (pos - own)];
+        }
+
+        const Benchmark &bench;
+        uint64_t rng;
+        size_t remaining;
+        size_t insert_begin, insert_cursor, insert_end;
+        size_t delete_cursor, delete_end;
+        KeySampler sampler;
+    };
+public:
+    Benchmark() {
+    }
+
+    // Read the keys file into data, type_name is the --key_type it should hold
+    template<class T>
+    long long read_key_file(T *&data, const std::string &type_name) {
+        long long num = 0;
         if (keys_file_type == "binary") {
-            table_size = load_binary_data(keys, table_size, keys_file_path);
-            if (table_size <= 0) {
-                COUT_THIS("Could not open key file, please check the path of key file.");
+            num = load_binary_data(data, table_size, keys_file_path);
+            if (num < 0) {
+                COUT_THIS("The size of " << keys_file_path << " does not match its key count for " << type_name
+                          << " keys, please check --key_type.");
                 exit(0);
             }
         } else if (keys_file_type == "text") {
-            table_size = load_text_data(keys, table_size, keys_file_path);
+            num = load_text_data(data, table_size, keys_file_path);
+        }
+        if (num <= 0) {
+            COUT_THIS("Could not open key file, please check the path of key file.");
+            exit(0);
+        }
+        return num;
+    }
+
+    // Read a file of string keys and encode them as integers for the indexes that need numeric
+    // keys. prefix keeps the order of the leading 8 bytes (keys sharing them collapse into one),
+    // rank numbers the distinct keys in order.
+    long long read_encoded_keys() {
+        StringKey *strings;
+        long long num = read_key_file(strings, "str");
+        if constexpr (std::is_same<KEY_TYPE, uint64_t>::value) {
+            keys = new KEY_TYPE[num];
+            advise_huge_pages(keys, num * sizeof(KEY_TYPE));
+            if (string_encoding == "prefix") {
+#pragma omp parallel for schedule(static)
+                for (long long i = 0; i < num; i++) {
+                    keys[i] = prefix_code(strings[i]);
+                }
+            } else {
+                std::vector<StringKey> sorted(strings, strings + num);
+                tbb::parallel_sort(sorted.begin(), sorted.end());
+                sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+#pragma omp parallel for schedule(static)
+                for (long long i = 0; i < num; i++) {
+                    keys[i] = std::lower_bound(sorted.begin(), sorted.end(), strings[i]) - sorted.begin();
+                }
+            }
+        }
+        delete[] strings;
+        return num;
+    }
+
+    KEY_TYPE *load_keys() {
+        // Sorted and deduplicated keys are cached next to the key file, so repeat runs
+        // only need to map the cache and shuffle it
+        std::string cache_path = keys_file_path + ".sorted_unique";
+        if (table_size > 0) cache_path += "." + std::to_string(table_size);
+        if (key_type != "u64") cache_path += "." + key_type;
+        if (!string_encoding.empty()) cache_path += "." + string_encoding;
+
+        if (key_cache && !data_shift && is_fresh_cache(cache_path, keys_file_path)) {
+            COUT_THIS("Reading sorted keys from cache " << cache_path);
+            MappedFile cache(cache_path);
+            const KEY_TYPE *sorted_keys;
+            table_size = map_binary_data(cache, sorted_keys, -1);
             if (table_size <= 0) {
-                COUT_THIS("Could not open key file, please check the path of key file.");
+                COUT_THIS("Could not read key cache, please remove " << cache_path);
                 exit(0);
             }
+            keys = new KEY_TYPE[table_size];
+            advise_huge_pages(keys, table_size * sizeof(KEY_TYPE));
+            parallel_shuffle(sorted_keys, table_size, keys, random_seed);
         } else {
-            COUT_THIS("Could not open key file, please check the path of key file.");
-            exit(0);
-        }
+            // Read keys from file
+            COUT_THIS("Reading data from file.");
+            table_size = string_encoding.empty() ? read_key_file(keys, key_type) : read_encoded_keys();
 
-        if (!data_shift) {
-            tbb::parallel_sort(keys, keys + table_size);
-            auto last = std::unique(keys, keys + table_size);
-            table_size = last - keys;
-            std::shuffle(keys, keys + table_size, gen);
+            if (!data_shift) {
+                tbb::parallel_sort(keys, keys + table_size);
+                KEY_TYPE *sorted_keys = new KEY_TYPE[table_size];
+                table_size = parallel_unique(keys, table_size, sorted_keys);
+                if (key_cache && !save_binary_data(sorted_keys, table_size, cache_path)) {
+                    COUT_THIS("Could not write key cache " << cache_path);
+                }
+                parallel_shuffle(sorted_keys, table_size, keys, random_seed);
+                delete[] sorted_keys;
+            }
         }
 
         init_table_size = init_table_ratio * table_size;
@@ -164,50 +429,186 @@ public:
         return keys;
     }
 
+    // Give every worker a fresh value arena and the bulk loaded keys fresh blobs
+    void make_blobs() {
+        value_arenas.clear();
+        for (int i = 0; i < std::max<int>(thread_num, omp_get_max_threads()); i++) {
+            value_arenas.emplace_back(new ValueArena(blob_size));
+        }
+        if constexpr (std::is_same<PAYLOAD_TYPE, uint64_t>::value) {
+#pragma omp parallel for schedule(static)
+            for (size_t i = 0; i < init_keys.size(); i++) {
+                init_key_values[i].second = value_arenas[omp_get_thread_num()]->make(123456789);
+            }
+        }
+    }
+
     inline void prepare(index_t *&index, const KEY_TYPE *keys) {
-        index = get_index<KEY_TYPE, PAYLOAD_TYPE>(index_type);
+        std::time_t t = std::time(nullptr);
+        char time_str[100];
+        run_id = std::strftime(time_str, sizeof(time_str), "%Y%m%d%H%M%S", std::localtime(&t)) ? time_str : "";
+
+        if (numa_active && numa == "interleave") {
+            // spread the index over all nodes, the workers keep the policy for their allocations
+#pragma omp parallel
+            interleave_memory(topology.node_num);
+        }
+
+        // with --memory every index instance allocates from an arena of its own, the one of the
+        // previous instance once that is released
+        index_arena.reset();
+        index_arena.reset(memory_record ? new IndexArena() : nullptr);
+        if (index_arena && !index_arena->ok()) {
+            COUT_THIS("[micro] cannot create a jemalloc arena, the arena statistics stay 0");
+        }
 
         // initilize Index (sort keys first)
         Param param = Param(thread_num, 0);
-        index->init(&param);
+        {
+            ArenaScope arena_scope(index_arena.get());
+            index = get_index<KEY_TYPE, PAYLOAD_TYPE>(index_type);
+            index->init(&param);
+        }
+        if (!bulkload_only) check_operations(index);
 
         // deal with the background thread case
         thread_num = param.worker_num;
 
+        if (blob_size > 0) make_blobs();
+
         COUT_THIS("bulk loading");
-        index->bulk_load(init_key_values, init_keys.size(), &param);
+        std::unique_ptr<PerfCounters> perf_counter(perf ? new PerfCounters : nullptr);
+        PerfCounters::Values perf_begin;
+        if (perf_counter) perf_begin = perf_counter->read();
+        reset_peak_rss();
+        long long rss_begin = get_proc_memory("VmRSS");
+        std::chrono::duration<double> bulk_load_time;
+        {
+            ArenaScope arena_scope(index_arena.get());
+            index->register_thread(&param);
+            auto bulk_load_begin = std::chrono::steady_clock::now();
+            index->bulk_load(init_key_values, init_keys.size(), &param);
+            bulk_load_time = std::chrono::steady_clock::now() - bulk_load_begin;
+            index->unregister_thread(&param);
+        }
+        if (perf_counter) stat.bulk_load_perf = perf_counter->read() - perf_begin;
+        stat.bulk_load_time = bulk_load_time.count();
+        stat.bulk_load_throughput = static_cast<uint64_t>(init_keys.size() / bulk_load_time.count());
+        stat.bulk_load_memory = get_proc_memory("VmHWM") - rss_begin;
+        index_keys = init_keys.size();
+        printf("bulk load: %.3f s, %llu keys/s, peak memory growth %lld bytes\n", stat.bulk_load_time,
+               stat.bulk_load_throughput, stat.bulk_load_memory);
+        if (verify_scan > 0 && index->supports_scan()) {
+            ArenaScope arena_scope(index_arena.get());
+            check_scans(index);
+        }
+    }
+
+    // --verify_scan: scans from random bulk loaded keys must return the keys and payloads that
+    // follow them in the sorted bulk load, as many as there are up to scan_num
+    void check_scans(index_t *index) {
+        const size_t n = init_keys.size();
+        if (n == 0) return;
+        Param param = Param(thread_num, 0);
+        index->register_thread(&param);
+        std::vector<std::pair<KEY_TYPE, PAYLOAD_TYPE>> result(scan_num);
+        uint64_t rng = random_seed;
+        for (size_t s = 0; s < verify_scan; s++) {
+            // the first scan starts at the smallest key
+            size_t begin = s == 0 ? 0 : (unsigned __int128) splitmix64(rng) * n >> 64;
+            size_t expected = std::min(scan_num, n - begin);
+            size_t scanned = index->scan(init_keys[begin], scan_num, result.data(), &param);
+            size_t i = 0;
+            while (i < std::min(scanned, expected) && result[i].first == init_key_values[begin + i].first &&
+                   memcmp(&result[i].second, &init_key_values[begin + i].second, sizeof(PAYLOAD_TYPE)) == 0) {
+                i++;
+            }
+            if (scanned != expected || i != expected) {
+                COUT_THIS("[micro] " << index_type << " scan of " << scan_num << " from " << init_keys[begin]
+                                     << " returned " << scanned << " entries, expected " << expected
+                                     << ", first mismatch at " << i);
+                exit(0);
+            }
+        }
+        index->unregister_thread(&param);
+        COUT_THIS("[micro] " << verify_scan << " scans of " << index_type << " match the bulk loaded keys");
     }
 
     /*
    * keys_file_path:      the path where keys file at
    * keys_file_type:      binary or text
+   * key_type:            u32, u64, i64, f64 or str, the type of the keys in keys file
+   * string_encoding:     prefix or rank, read string keys and encode them as u64 keys
+   * payload_size:        8, 16 or 32, the bytes of every payload stored in the index
+   * blob_size:           store values out of line as blobs of this many bytes
    * read_ratio:          the ratio of read operation
    * insert_ratio         the ratio of insert operation
    * delete_ratio         the ratio of delete operation
    * update_ratio         the ratio of update operation
    * scan_ratio           the ratio of scan operation
+   * rmw_ratio            the ratio of read-modify-write operation
    * scan_num             the number of keys that every scan operation need to scan
+   * verify_scan          check this many scans of every bulk loaded index against the sorted keys
    * operations_num      the number of operations(read, insert, delete, update, scan)
    * table_size           the total number of keys in key file
    * init_table_size      the number of keys that will be used in bulk loading
    * thread_num           the number of worker thread
    * index_type           the type of index(xindex, hot, alex...). Detail could be refered to src/competitor
-   * sample_distribution  the distribution of
+   * sample_distribution  the distribution of the keys that are read: uniform, zipf, hotspot, latest or sequential
+   * zipf_theta           the skew of zipf and latest, between 0 and 1
+   * hotspot_keys         the fraction of the keys that are hot in hotspot
+   * hotspot_ops          the fraction of the accesses that go to the hot keys in hotspot
    * latency_sample_ratio the ratio of latency sampling
    * error_bound          the error bound of PGM metric
    * output_path          the path to store result
+   * key_cache            cache the sorted and deduplicated keys next to the key file
+   * op_stream            generate operations on the fly in every worker instead of materializing them
+   * schedule             how operations are handed to workers: dynamic, static, guided or partition
+   * chunk_size           the chunk size of the dynamic, static and guided schedules
+   * target_qps           comma separated total request rates to sweep in open-loop mode (closed-loop if unset)
+   * arrival              the open-loop arrival process: poisson or constant
+   * timeline_interval    the period in ms of the throughput/latency time series (disabled if 0)
+   * timeline_path        the path to store the time series
+   * perf                 count hardware events per phase and per sampled operation with perf_event_open
+   * bulkload_only        only bulk load every index and report its build time, speed and memory
+   * batch_size           issue reads to the index multi_get in batches of this many keys
+   * interleave           run every read batch as this many interleaved lookups instead (0 disables)
+   * virtual_dispatch     call the index through indexInterface instead of its concrete type
+   * pin                  pin workers to cpus: none, compact, scatter or a cpu list such as 0-3,8
+   * numa                 NUMA placement: none, local, interleave or replicate-ops
+   * warmup_ops           untimed lookups of bulk loaded keys before every run
+   * warmup_seconds       run the untimed lookups for this long instead
+   * repeat               the number of trials, each on a fresh index
+   * workload             a YCSB preset (ycsb-a to ycsb-f) or a file of phases that replaces the mix above
+   * record_trace         write the generated operations to this binary trace (one file per phase)
+   * replay_trace         run the operations of a binary trace instead of generating them
   */
     inline void parse_args(int argc, char **argv) {
         auto flags = parse_flags(argc, argv);
         keys_file_path = get_required(flags, "keys_file"); // required
         keys_file_type = get_with_default(flags, "keys_file_type", "binary");
-        read_ratio = stod(get_required(flags, "read")); // required
+        key_type = get_with_default(flags, "key_type", "u64");
+        string_encoding = get_with_default(flags, "string_encoding", "");
+        payload_size = stoi(get_with_default(flags, "payload_size", "8"));
+        blob_size = stoi(get_with_default(flags, "blob_size", "0"));
+        INVARIANT(payload_size == sizeof(PAYLOAD_TYPE));
+        INVARIANT(blob_size % sizeof(uint64_t) == 0 && (blob_size == 0 || payload_size == sizeof(uint64_t)));
+        INVARIANT(string_encoding.empty() || ((string_encoding == "prefix" || string_encoding == "rank") && key_type == "u64"));
+        workload = get_with_default(flags, "workload", "");
+        record_trace = get_with_default(flags, "record_trace", "");
+        replay_trace = get_with_default(flags, "replay_trace", "");
+        bool mix_flags = workload.empty() && replay_trace.empty();
+        read_ratio = stod(mix_flags ? get_required(flags, "read") : get_with_default(flags, "read", "0")); // required
         insert_ratio = stod(get_with_default(flags, "insert", "0")); // required
         delete_ratio = stod(get_with_default(flags, "delete", "0"));
         update_ratio = stod(get_with_default(flags, "update", "0"));
         scan_ratio = stod(get_with_default(flags, "scan", "0"));
+        rmw_ratio = stod(get_with_default(flags, "rmw", "0"));
         scan_num = stoi(get_with_default(flags, "scan_num", "100"));
+        max_scan_num = scan_num;
+        verify_scan = stoul(get_with_default(flags, "verify_scan", "0"));
         operations_num = stoi(get_with_default(flags, "operations_num", "1000000000")); // required
+        operations_num_given = flags.count("operations_num") > 0;
         table_size = stoi(get_with_default(flags, "table_size", "-1"));
         init_table_ratio = stod(get_with_default(flags, "init_table_ratio", "0.5"));
         del_table_ratio = stod(get_with_default(flags, "del_table_ratio", "0.5"));
@@ -215,6 +616,9 @@ public:
         all_thread_num = get_comma_separated(flags, "thread_num"); // required
         all_index_type = get_comma_separated(flags, "index"); // required
         sample_distribution = get_with_default(flags, "sample_distribution", "uniform");
+        zipf_theta = stod(get_with_default(flags, "zipf_theta", "0.99"));
+        hotspot_keys = stod(get_with_default(flags, "hotspot_keys", "0.2"));
+        hotspot_ops = stod(get_with_default(flags, "hotspot_ops", "0.8"));
         latency_sample = get_boolean_flag(flags, "latency_sample");
         latency_sample_ratio = stod(get_with_default(flags, "latency_sample_ratio", "0.01"));
         error_bound = stoi(get_with_default(flags, "error_bound", "64"));
@@ -224,35 +628,196 @@ public:
         memory_record = get_boolean_flag(flags, "memory");
         dataset_statistic = get_boolean_flag(flags, "dataset_statistic");
         data_shift = get_boolean_flag(flags, "data_shift");
+        key_cache = get_boolean_flag(flags, "key_cache");
+        op_stream = get_boolean_flag(flags, "op_stream");
+        schedule = get_with_default(flags, "schedule", "dynamic");
+        chunk_size = stoul(get_with_default(flags, "chunk_size", "10000"));
+        all_target_qps = get_comma_separated(flags, "target_qps");
+        arrival = get_with_default(flags, "arrival", "poisson");
+        timeline_interval = stoul(get_with_default(flags, "timeline_interval", "0"));
+        timeline_path = get_with_default(flags, "timeline_path", "./timeline.csv");
+        perf = get_boolean_flag(flags, "perf");
+        bulkload_only = get_boolean_flag(flags, "bulkload_only");
+        batch_size = stoul(get_with_default(flags, "batch_size", "1"));
+        interleave = stoul(get_with_default(flags, "interleave", "0"));
+        virtual_dispatch = get_boolean_flag(flags, "virtual_dispatch");
+        pin = get_with_default(flags, "pin", "none");
+        numa = get_with_default(flags, "numa", "none");
+        warmup_ops = stoul(get_with_default(flags, "warmup_ops", "0"));
+        warmup_seconds = stod(get_with_default(flags, "warmup_seconds", "0"));
+        repeat = stoul(get_with_default(flags, "repeat", "1"));
+        if (!all_target_qps.empty()) latency_sample = true;
 
-        COUT_THIS("[micro] Read:Insert:Update:Scan:Delete= " << read_ratio << ":" << insert_ratio << ":" << update_ratio << ":"
-                                                      << scan_ratio << ":" << delete_ratio);
-        double ratio_sum = read_ratio + insert_ratio + delete_ratio + update_ratio + scan_ratio;
-        double insert_delete = insert_ratio + delete_ratio;
-        INVARIANT(insert_delete == insert_ratio || insert_delete == delete_ratio);
-        INVARIANT(ratio_sum > 0.9999 && ratio_sum < 1.0001);  // avoid precision lost
-        INVARIANT(sample_distribution == "zipf" || sample_distribution == "uniform");
+        if (workload.empty()) {
+            Phase phase;
+            phase.name = "run";
+            phase.read_ratio = read_ratio;
+            phase.insert_ratio = insert_ratio;
+            phase.delete_ratio = delete_ratio;
+            phase.update_ratio = update_ratio;
+            phase.scan_ratio = scan_ratio;
+            phase.rmw_ratio = rmw_ratio;
+            phase.sample_distribution = sample_distribution;
+            phase.zipf_theta = zipf_theta;
+            phase.hotspot_keys = hotspot_keys;
+            phase.hotspot_ops = hotspot_ops;
+            phase.operations_num = operations_num;
+            phases.push_back(phase);
+        } else {
+            phases = parse_workload(workload);
+        }
+        INVARIANT(replay_trace.empty() || (workload.empty() && !op_stream));
+        INVARIANT(record_trace.empty() || !op_stream);  // streamed operations are never materialized
+        for (auto &phase : phases) {
+            if (!replay_trace.empty()) break;  // the trace has its own mix
+            COUT_THIS("[micro] " << phase.name << " Read:Insert:Update:Scan:Delete:RMW= " << phase.read_ratio << ":"
+                                 << phase.insert_ratio << ":" << phase.update_ratio << ":" << phase.scan_ratio << ":"
+                                 << phase.delete_ratio << ":" << phase.rmw_ratio);
+            double ratio_sum = phase.read_ratio + phase.insert_ratio + phase.delete_ratio + phase.update_ratio +
+                               phase.scan_ratio + phase.rmw_ratio;
+            double insert_delete = phase.insert_ratio + phase.delete_ratio;
+            INVARIANT(insert_delete == phase.insert_ratio || insert_delete == phase.delete_ratio);
+            INVARIANT(ratio_sum > 0.9999 && ratio_sum < 1.0001);  // avoid precision lost
+            KeyDistribution::Kind kind;
+            INVARIANT(KeyDistribution::parse(phase.sample_distribution, kind));
+            INVARIANT(phase.zipf_theta > 0 && phase.zipf_theta < 1);
+            INVARIANT(phase.hotspot_keys > 0 && phase.hotspot_keys <= 1);
+            INVARIANT(phase.hotspot_ops >= 0 && phase.hotspot_ops <= 1);
+        }
+        INVARIANT(arrival == "poisson" || arrival == "constant");
+        INVARIANT(schedule == "dynamic" || schedule == "static" || schedule == "guided" || schedule == "partition");
         INVARIANT(all_thread_num.size() > 0);
+        INVARIANT(batch_size > 0);
+        INVARIANT(interleave == 0 || batch_size > 1);
+        INVARIANT(interleave <= MAX_INTERLEAVE);
+        INVARIANT(numa == "none" || numa == "local" || numa == "interleave" || numa == "replicate-ops");
+        INVARIANT(numa == "none" || numa == "interleave" || pin != "none");  // placement follows the pinned cpus
+        INVARIANT(repeat > 0);
+
+        COUT_THIS("[micro] " << topology.cpus.size() << " cpus on " << topology.node_num << " NUMA node(s)");
+        if (pin != "none") {
+            pin_cpus = topology.placement(pin);
+            INVARIANT(!pin_cpus.empty());
+        }
+        numa_active = numa != "none" && topology.node_num > 1;
+        if (numa != "none" && !numa_active) {
+            COUT_THIS("[micro] single NUMA node, --numa=" << numa << " has no effect");
+        }
+        // a dynamic or guided schedule hands a chunk to whichever worker is free, not to the one
+        // whose node it was copied to
+        if (numa_active && numa == "local" && schedule != "static" && schedule != "partition") {
+            COUT_THIS("[micro] --numa=local needs --schedule=static or partition, it has no effect with " << schedule);
+            numa_active = false;
+        }
     }
 
 
-    void generate_operations(KEY_TYPE *keys) {
-        // prepare operations
-        operations.reserve(operations_num);
-        COUT_THIS("sample keys.");
-        KEY_TYPE *sample_ptr = nullptr;
-        if (sample_distribution == "uniform") {
-            sample_ptr = get_search_keys(&init_keys[0], init_table_size, operations_num, &random_seed);
-        } else if (sample_distribution == "zipf") {
-            sample_ptr = get_search_keys_zipf(&init_keys[0], init_table_size, operations_num, &random_seed);
+    // The YCSB core workloads on the bulk loaded table, whose load phase is the bulk load.
+    static std::string workload_preset(const std::string &name) {
+        if (name == "ycsb-a") return "name=ycsb-a read=0.5 update=0.5 distribution=zipf";
+        if (name == "ycsb-b") return "name=ycsb-b read=0.95 update=0.05 distribution=zipf";
+        if (name == "ycsb-c") return "name=ycsb-c read=1 distribution=zipf";
+        if (name == "ycsb-d") return "name=ycsb-d read=0.95 insert=0.05 distribution=latest";
+        if (name == "ycsb-e") return "name=ycsb-e scan=0.95 insert=0.05 distribution=zipf";
+        if (name == "ycsb-f") return "name=ycsb-f read=0.5 rmw=0.5 distribution=zipf";
+        return "";
+    }
+
+    // Parse a preset or a workload file. Every line is a phase of space separated key=value
+    // fields: name, read, insert, update, scan, delete, rmw, distribution, zipf_theta,
+    // hotspot_keys, hotspot_ops, operations, seconds and threads. Ratios left out are 0, the
+    // rest defaults to the command line flags.
+    std::vector<Phase> parse_workload(const std::string &spec) {
+        std::string text = workload_preset(spec);
+        if (text.empty()) {
+            std::ifstream in(spec);
+            if (!in.is_open()) {
+                COUT_THIS("[micro] cannot open workload " << spec);
+                exit(0);
+            }
+            std::stringstream buffer;
+            buffer << in.rdbuf();
+            text = buffer.str();
         }
+        std::vector<Phase> result;
+        std::stringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::stringstream fields(line.substr(0, line.find('#')));
+            std::string field;
+            Phase phase;
+            bool operations_given = operations_num_given;
+            phase.name = "phase" + std::to_string(result.size());
+            phase.sample_distribution = sample_distribution;
+            phase.zipf_theta = zipf_theta;
+            phase.hotspot_keys = hotspot_keys;
+            phase.hotspot_ops = hotspot_ops;
+            phase.operations_num = operations_num;
+            bool empty = true;
+            while (fields >> field) {
+                empty = false;
+                size_t equals = field.find('=');
+                std::string key = field.substr(0, equals);
+                std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+                if (key == "name") phase.name = value;
+                else if (key == "read") phase.read_ratio = stod(value);
+                else if (key == "insert") phase.insert_ratio = stod(value);
+                else if (key == "update") phase.update_ratio = stod(value);
+                else if (key == "scan") phase.scan_ratio = stod(value);
+                else if (key == "delete") phase.delete_ratio = stod(value);
+                else if (key == "rmw") phase.rmw_ratio = stod(value);
+                else if (key == "distribution") phase.sample_distribution = value;
+                else if (key == "zipf_theta") phase.zipf_theta = stod(value);
+                else if (key == "hotspot_keys") phase.hotspot_keys = stod(value);
+                else if (key == "hotspot_ops") phase.hotspot_ops = stod(value);
+                else if (key == "operations") {
+                    phase.operations_num = stoul(value);
+                    operations_given = true;
+                }
+                else if (key == "seconds") phase.seconds = stod(value);
+                else if (key == "threads") phase.thread_num = stoul(value);
+                else {
+                    COUT_THIS("[micro] unknown workload field " << key);
+                    exit(0);
+                }
+            }
+            if (empty) continue;
+            // the operations of a phase are generated before it starts, and without a count
+            // that would be the default --operations_num however short the phase is
+            if (phase.seconds > 0 && !operations_given && !op_stream) {
+                COUT_THIS("[micro] phase " << phase.name << " sets seconds but no operations: give it operations=, "
+                          "pass --operations_num or run with --op_stream");
+                exit(0);
+            }
+            result.push_back(phase);
+        }
+        INVARIANT(!result.empty());
+        return result;
+    }
 
-        // generate operations(read, insert, update, scan)
-        COUT_THIS("generate operations.");
-        std::uniform_real_distribution<> ratio_dis(0, 1);
-        size_t sample_counter = 0, insert_counter = init_table_size;
-        size_t delete_counter = table_size * (1 - del_table_ratio);
+    // Switch to a phase. thread_limit is the thread count the index was created for.
+    void apply_phase(const Phase &phase, size_t sweep_thread_num, size_t thread_limit) {
+        read_ratio = phase.read_ratio;
+        insert_ratio = phase.insert_ratio;
+        delete_ratio = phase.delete_ratio;
+        update_ratio = phase.update_ratio;
+        scan_ratio = phase.scan_ratio;
+        rmw_ratio = phase.rmw_ratio;
+        sample_distribution = phase.sample_distribution;
+        zipf_theta = phase.zipf_theta;
+        hotspot_keys = phase.hotspot_keys;
+        hotspot_ops = phase.hotspot_ops;
+        operations_num = phase.operations_num;
+        phase_seconds = phase.seconds;
+        thread_num = std::min(phase.thread_num ? phase.thread_num : sweep_thread_num, thread_limit);
+    }
+
+    void reset_cursors() {
+        insert_cursor = init_table_size;
+        delete_cursor = table_size * (1 - del_table_ratio);
+    }
 
+    void shift_keys(KEY_TYPE *keys) {
         if (data_shift) {
             size_t rest_key_num = table_size - init_table_size;
             if(rest_key_num > 0) {
@@ -260,7 +825,64 @@ public:
                 std::random_shuffle(keys + init_table_size, keys + table_size);
             }
         }
-        
+    }
+
+    // The key distribution of the current phase. zeta is summed once per key count and theta,
+    // the hot range of hotspot starts at a position drawn from the phase seed.
+    KeyDistribution make_distribution(uint64_t seed) {
+        KeyDistribution dist;
+        KeyDistribution::parse(sample_distribution, dist.kind);
+        dist.num_keys = init_table_size;
+        dist.zipf_theta = zipf_theta;
+        if (dist.kind == KeyDistribution::ZIPF || dist.kind == KeyDistribution::LATEST) {
+            auto &zetan = zeta_cache[std::make_pair(dist.num_keys, zipf_theta)];
+            if (zetan == 0) zetan = zeta(dist.num_keys, zipf_theta);
+            dist.zetan = zetan;
+        }
+        dist.hot_keys = std::min(dist.num_keys, std::max<size_t>(1, hotspot_keys * dist.num_keys));
+        dist.hot_begin = (unsigned __int128) splitmix64(seed) * (dist.num_keys - dist.hot_keys + 1) >> 64;
+        dist.hot_ops = hotspot_ops;
+        return dist;
+    }
+
+    // the distribution with its parameters for the csv, such as zipf:0.99 or hotspot:0.2:0.8
+    std::string distribution_name() {
+        if (!replay_trace.empty()) return "";
+        std::stringstream ss;
+        ss << sample_distribution;
+        if (sample_distribution == "zipf" || sample_distribution == "latest") ss << ":" << zipf_theta;
+        if (sample_distribution == "hotspot") ss << ":" << hotspot_keys << ":" << hotspot_ops;
+        return ss.str();
+    }
+
+    // Generate the operations of the current phase, inserting and deleting from the cursors.
+    // The generator is reseeded per phase, so every index gets the same operations.
+    void generate_operations(KEY_TYPE *keys) {
+        size_t phase_seed = random_seed + phase_id;
+        distribution = make_distribution(phase_seed);
+        if (op_stream) {
+            COUT_THIS("operations are generated by every worker while running.");
+            return;
+        }
+
+        // prepare operations
+        operations.clear();
+        operations.reserve(operations_num);
+        COUT_THIS("sample keys.");
+        gen.seed(phase_seed);
+        size_t *sample_ptr = sample_positions(distribution, operations_num, phase_seed);
+
+        // generate operations(read, insert, update, scan)
+        COUT_THIS("generate operations.");
+        std::uniform_real_distribution<> ratio_dis(0, 1);
+        size_t sample_counter = 0;
+        size_t &insert_counter = insert_cursor;
+        size_t &delete_counter = delete_cursor;
+        // latest positions count back from the last key inserted so far
+        auto sample_key = [&](size_t pos) {
+            return distribution.kind == KeyDistribution::LATEST ? keys[insert_counter - 1 - pos] : init_keys[pos];
+        };
+
         size_t temp_counter = 0;
         for (size_t i = 0; i < operations_num; ++i) {
             auto prob = ratio_dis(gen);
@@ -269,71 +891,288 @@ public:
                 //     operations_num = i;
                 //     break;
                 // }
-                // operations.push_back(std::pair<Operation, KEY_TYPE>(READ, keys[temp_counter++]));
-                operations.push_back(std::pair<Operation, KEY_TYPE>(READ, sample_ptr[sample_counter++]));
+                // operations.push_back(operation_t{keys[temp_counter++], 0, READ});
+                operations.push_back(operation_t{sample_key(sample_ptr[sample_counter++]), 0, READ});
             } else if (prob < read_ratio + insert_ratio) {
                 if (insert_counter >= table_size) {
                     operations_num = i;
                     break;
                 }
-                operations.push_back(std::pair<Operation, KEY_TYPE>(INSERT, keys[insert_counter++]));
+                operations.push_back(operation_t{keys[insert_counter++], 0, INSERT});
             } else if (prob < read_ratio + insert_ratio + update_ratio) {
-                operations.push_back(std::pair<Operation, KEY_TYPE>(UPDATE, sample_ptr[sample_counter++]));
+                operations.push_back(operation_t{sample_key(sample_ptr[sample_counter++]), 0, UPDATE});
             } else if (prob < read_ratio + insert_ratio + update_ratio + scan_ratio) {
-                operations.push_back(std::pair<Operation, KEY_TYPE>(SCAN, sample_ptr[sample_counter++]));
+                operations.push_back(operation_t{sample_key(sample_ptr[sample_counter++]), 0, SCAN});
+            } else if (prob < read_ratio + insert_ratio + update_ratio + scan_ratio + rmw_ratio) {
+                operations.push_back(operation_t{sample_key(sample_ptr[sample_counter++]), 0, RMW});
             } else {
                 if (delete_counter >= table_size) {
                     operations_num = i;
                     break;
                 }
-                operations.push_back(std::pair<Operation, KEY_TYPE>(DELETE, keys[delete_counter++]));
-                // operations.push_back(std::pair<Operation, KEY_TYPE>(DELETE, sample_ptr[sample_counter++]));
+                operations.push_back(operation_t{keys[delete_counter++], 0, DELETE});
+                // operations.push_back(operation_t{sample_ptr[sample_counter++], 0, DELETE});
             }
         }
 
         COUT_VAR(operations.size());
+        operation_data = operations.data();
 
         delete[] sample_ptr;
+
+        if (!record_trace.empty() && !trace_recorded[phase_id]) {
+            // the generator is deterministic, so every phase is recorded once
+            std::string path = phases.size() == 1 ? record_trace : record_trace + "." + phases[phase_id].name;
+            if (!save_trace(operations.data(), operations.size(), path)) {
+                COUT_THIS("[micro] cannot write trace " << path);
+                exit(0);
+            }
+            COUT_THIS("[micro] recorded " << operations.size() << " operations to " << path);
+            trace_recorded[phase_id] = true;
+        }
+    }
+
+    // Refuse to run operations the index leaves out, rather than time them as no-ops
+    void check_operations(index_t *index) {
+        bool update = false, remove = false, scan = false;
+        for (auto &phase : phases) {
+            update |= phase.update_ratio > 0 || phase.rmw_ratio > 0;
+            remove |= phase.delete_ratio > 0;
+            scan |= phase.scan_ratio > 0;
+        }
+        if (!replay_trace.empty()) {
+            update = replay_op_num[UPDATE] + replay_op_num[RMW] > 0;
+            remove = replay_op_num[DELETE] > 0;
+            scan = replay_op_num[SCAN] > 0;
+        }
+        const char *missing = update && !index->supports_update() ? "update"
+                              : remove && !index->supports_remove() ? "delete"
+                              : scan && !index->supports_scan() ? "scan" : nullptr;
+        if (missing) {
+            COUT_THIS("[micro] " << index_type << " does not support " << missing << ", which the workload runs");
+            exit(0);
+        }
+    }
+
+    // Map a --replay_trace in place of generated operations. Returns the longest scan in it.
+    size_t map_replay_trace() {
+        trace_file.reset(new MappedFile(replay_trace));
+        long long count = map_trace(*trace_file, operation_data);
+        if (count < 0) {
+            COUT_THIS("[micro] " << replay_trace << " is not a trace of " << sizeof(KEY_TYPE) << "-byte keys");
+            exit(0);
+        }
+        const operation_t *records = operation_data;
+        size_t bad_ops = 0, longest_scan = 0;
+        size_t op_num[OPERATION_NUM] = {};
+#pragma omp parallel for schedule(static) reduction(+:bad_ops, op_num[:OPERATION_NUM]) reduction(max:longest_scan)
+        for (long long i = 0; i < count; i++) {
+            if (records[i].op >= OPERATION_NUM) {
+                bad_ops++;
+                continue;
+            }
+            op_num[records[i].op]++;
+            if (records[i].op == SCAN) longest_scan = std::max<size_t>(longest_scan, records[i].arg);
+        }
+        std::copy(op_num, op_num + OPERATION_NUM, replay_op_num);
+        if (bad_ops) {
+            COUT_THIS("[micro] " << replay_trace << " has " << bad_ops << " unknown op codes");
+            exit(0);
+        }
+        operations_num = count;
+        COUT_THIS("[micro] replaying " << count << " operations from " << replay_trace);
+        return longest_scan;
+    }
+
+    // the cpus the workers run on, space separated
+    std::string pinned_cpus() {
+        std::string cpus;
+        for (size_t t = 0; t < thread_num && !pin_cpus.empty(); t++) {
+            cpus += (t ? " " : "") + std::to_string(pin_cpus[t % pin_cpus.size()]);
+        }
+        return cpus;
+    }
+
+    // --numa=local|replicate-ops, called by every worker before the run. The operations are
+    // copied into memory first touched by the pinned workers that read them: one copy split by
+    // worker (local) or one copy per node (replicate-ops). Returns the array the worker reads.
+    const operation_t *place_operations(int thread_id, std::vector<operation_t *> &copies) {
+        if (!numa_active || op_stream || numa == "interleave") return operation_data;
+        auto node_of_thread = [&](size_t t) { return topology.node_of(pin_cpus[t % pin_cpus.size()]); };
+        const int node = node_of_thread(thread_id);
+        const size_t copy = numa == "local" ? 0 : node;
+#pragma omp master
+        {
+            copies.assign(numa == "local" ? 1 : topology.node_num, nullptr);
+            for (auto &c : copies) {
+                c = static_cast<operation_t *>(alloc_untouched(operations_num * sizeof(operation_t)));
+            }
+        }
+#pragma omp barrier
+        auto *src = operation_data;
+        auto *dst = copies[copy];
+        if (numa == "local" && schedule == "static") {
+            // the chunks schedule(static, chunk_size) hands to this thread
+            for (size_t i = thread_id * chunk_size; i < operations_num; i += thread_num * chunk_size) {
+                std::copy(src + i, src + std::min(i + chunk_size, operations_num), dst + i);
+            }
+        } else {
+            // a contiguous share, of all workers (local, partition schedule) or of the workers on
+            // this node (replicate-ops)
+            size_t rank = thread_id, count = thread_num;
+            if (numa == "replicate-ops") {
+                rank = count = 0;
+                for (size_t t = 0; t < thread_num; t++) {
+                    if (node_of_thread(t) != node) continue;
+                    rank += t < (size_t) thread_id;
+                    count++;
+                }
+            }
+            size_t begin = operations_num * rank / count, end = operations_num * (rank + 1) / count;
+            std::copy(src + begin, src + end, dst + begin);
+        }
+#pragma omp barrier
+        return dst;
     }
 
     void run(index_t *index) {
+        if (virtual_dispatch) {
+            run_typed(index);
+        } else {
+            // one instance of the run loop per adapter, so that index calls are not virtual
+            dispatch_index<KEY_TYPE, PAYLOAD_TYPE>(index_type, index, [&](auto *typed_index) {
+                run_typed(typed_index);
+            });
+        }
+    }
+
+    template<class IndexT>
+    void run_typed(IndexT *index) {
         std::thread *thread_array = new std::thread[thread_num];
-        param_t params[thread_num];
+        std::vector<param_t> params(thread_num);
         TSCNS tn;
         tn.init();
         printf("Begin running\n");
+        if (!pin_cpus.empty()) {
+            COUT_THIS("[micro] workers pinned to cpus " << pinned_cpus());
+        }
+        std::vector<operation_t *> op_copies;
         auto start_time = tn.rdtsc();
         auto end_time = tn.rdtsc();
+        if (schedule == "static") {
+            omp_set_schedule(omp_sched_static, chunk_size);
+        } else if (schedule == "guided") {
+            omp_set_schedule(omp_sched_guided, chunk_size);
+        } else {
+            omp_set_schedule(omp_sched_dynamic, chunk_size);
+        }
+        reset_peak_rss();
+        std::atomic<bool> timeline_stop(false);
+        std::thread timeline_thread;
+        if (timeline_interval > 0) {
+            timeline_thread = std::thread([&]() { sample_timeline(params, tn, timeline_stop); });
+        }
     //    System::profile("perf.data", [&]() {
 #pragma omp parallel num_threads(thread_num)
         {
             // thread specifier
             auto thread_id = omp_get_thread_num();
             auto paramI = Param(thread_num, thread_id);
+            if (!pin_cpus.empty()) pin_thread(pin_cpus[thread_id % pin_cpus.size()]);
+            if (numa_active && numa == "interleave") interleave_memory(topology.node_num);
+            const operation_t *ops = place_operations(thread_id, op_copies);
             // Latency Sample Variable
             int latency_sample_interval = operations_num / (operations_num * latency_sample_ratio);
             auto latency_sample_start_time = tn.rdtsc();
             auto latency_sample_end_time = tn.rdtsc();
             param_t &thread_param = params[thread_id];
-            thread_param.latency.reserve(operations_num / latency_sample_interval);
             // Operation Parameter
             PAYLOAD_TYPE val;
-            std::pair <KEY_TYPE, PAYLOAD_TYPE> *scan_result = new std::pair<KEY_TYPE, PAYLOAD_TYPE>[scan_num];
-            // waiting all thread ready
-#pragma omp barrier
-#pragma omp master
-            start_time = tn.rdtsc();
-// running benchmark
-#pragma omp for schedule(dynamic, 10000)
-            for (auto i = 0; i < operations_num; i++) {
-                auto op = operations[i].first;
-                auto key = operations[i].second;
-
-                if (latency_sample && i % latency_sample_interval == 0)
+            // With --blob_size writes store a new blob and reads follow the payload to read theirs
+            ValueArena *arena = blob_size > 0 ? value_arenas[thread_id].get() : nullptr;
+            uint64_t blob_checksum = 0;
+            auto make_value = [&](uint64_t value) -> PAYLOAD_TYPE {
+                if constexpr (std::is_same<PAYLOAD_TYPE, uint64_t>::value) {
+                    if (arena) return arena->make(value);
+                }
+                return value;
+            };
+            auto read_value = [&](const PAYLOAD_TYPE &value) -> uint64_t {
+                if constexpr (std::is_same<PAYLOAD_TYPE, uint64_t>::value) {
+                    if (arena) return ValueArena::read(value, blob_size, blob_checksum);
+                }
+                return value;
+            };
+            std::pair <KEY_TYPE, PAYLOAD_TYPE> *scan_result = new std::pair<KEY_TYPE, PAYLOAD_TYPE>[max_scan_num];
+            // Open-loop pacing: every thread issues target_qps / thread_num requests per second on
+            // its own arrival schedule. Latency is measured from the intended start time, so a
+            // stalled operation is charged for the requests queued up behind it.
+            const bool open_loop = target_qps > 0;
+            const double arrival_interval = open_loop ? thread_num * 1e9 / target_qps / tn.tsc_ghz_inv : 0;
+            std::mt19937_64 arrival_gen(random_seed + thread_id);
+            std::exponential_distribution<double> arrival_dis(1.0);
+            double intended_time = 0;
+            // counters are per thread, so every worker opens its own
+            std::unique_ptr<PerfCounters> perf_counter(perf ? new PerfCounters : nullptr);
+            PerfCounters::Values perf_begin, op_perf_begin;
+            // With --batch_size > 1 reads are buffered and issued together through multi_get.
+            // A batched read's latency runs from its own (intended) start until its batch returns.
+            std::vector<KEY_TYPE> batch_keys(batch_size);
+            std::vector<PAYLOAD_TYPE> batch_vals(batch_size);
+            std::unique_ptr<bool[]> batch_found(new bool[batch_size]);
+            std::vector<int64_t> batch_start(batch_size);
+            size_t batch_count = 0;
+            auto flush_batch = [&]() {
+                if (batch_count == 0) return;
+                if (interleave) {
+                    thread_param.success_read += index->interleaved_get(batch_keys.data(), batch_count,
+                                                                        batch_vals.data(), batch_found.get(),
+                                                                        interleave, &paramI);
+                } else {
+                    thread_param.success_read += index->multi_get(batch_keys.data(), batch_count, batch_vals.data(),
+                                                                  batch_found.get(), &paramI);
+                }
+                if (arena) {
+                    for (size_t b = 0; b < batch_count; b++) {
+                        if (batch_found[b]) read_value(batch_vals[b]);
+                    }
+                }
+                thread_param.operations.store(thread_param.operations.load(std::memory_order_relaxed) + batch_count,
+                                              std::memory_order_relaxed);
+                if (latency_sample) {
+                    latency_sample_end_time = tn.rdtsc();
+                    for (size_t b = 0; b < batch_count; b++) {
+                        if (batch_start[b] >= 0)
+                            thread_param.latency[READ].record(latency_sample_end_time - batch_start[b]);
+                    }
+                }
+                batch_count = 0;
+            };
+            auto do_operation = [&](size_t i, Operation op, KEY_TYPE key, uint32_t arg) {
+                const bool sampled = i % latency_sample_interval == 0;
+                const bool batched = op == READ && batch_size > 1;
+                if (open_loop) {
+                    intended_time += arrival == "poisson" ? arrival_interval * arrival_dis(arrival_gen) : arrival_interval;
+                    while (tn.rdtsc() < (int64_t) intended_time) {
+                        __builtin_ia32_pause();
+                    }
+                    if (latency_sample && sampled)
+                        latency_sample_start_time = (int64_t) intended_time;
+                } else if (latency_sample && sampled)
                     latency_sample_start_time = tn.rdtsc();
+                // read after the pacing wait, so the counters cover only the operation
+                if (perf_counter && sampled && !batched)
+                    op_perf_begin = perf_counter->read_fast();
 
+                if (batched) {
+                    batch_keys[batch_count] = key;
+                    batch_start[batch_count] = latency_sample && sampled ? (int64_t) latency_sample_start_time : -1;
+                    if (++batch_count == batch_size) flush_batch();
+                    return;
+                }
                 if (op == READ) {  // get
                     auto ret = index->get(key, val, &paramI);
+                    if (ret && arena) read_value(val);
                     // if(!ret) {
                     //     printf("read not found, Key %lu\n",key);
                     //     continue;
@@ -344,41 +1183,133 @@ public:
                     // }
                     thread_param.success_read += ret;
                 } else if (op == INSERT) {  // insert
-                    auto ret = index->put(key, 123456789, &paramI);
+                    auto ret = index->put(key, make_value(arg ? arg : 123456789), &paramI);
                     thread_param.success_insert += ret;
                 } else if (op == UPDATE) {  // update
-                    auto ret = index->update(key, 234567891, &paramI);
+                    auto ret = index->update(key, make_value(arg ? arg : 234567891), &paramI);
                     thread_param.success_update += ret;
                 } else if (op == SCAN) { // scan
-                    auto scan_len = index->scan(key, scan_num, scan_result, &paramI);
-                    if (scan_len != scan_num) {
+                    size_t scan_len = arg ? arg : scan_num;
+                    // not every index fills the results, so blobs are only read from the ones it did
+                    if (arena) std::fill(scan_result, scan_result + scan_len, std::pair<KEY_TYPE, PAYLOAD_TYPE>());
+                    size_t scanned = index->scan(key, scan_len, scan_result, &paramI);
+                    if (scanned != scan_len) {
                         thread_param.scan_not_enough++;
                     }
+                    if (arena) {
+                        for (size_t s = 0; s < std::min(scanned, scan_len); s++) {
+                            if (scan_result[s].second) read_value(scan_result[s].second);
+                        }
+                    }
                 } else if (op == DELETE) { // delete
                     auto ret = index->remove(key, &paramI);
                     thread_param.success_remove += ret;
+                } else if (op == RMW) { // read-modify-write
+                    auto ret = index->get(key, val, &paramI);
+                    if (ret) ret = index->update(key, make_value(read_value(val) + 1), &paramI);
+                    thread_param.success_update += ret;
                 }
+                thread_param.operations.store(thread_param.operations.load(std::memory_order_relaxed) + 1,
+                                              std::memory_order_relaxed);
 
-                if (latency_sample && i % latency_sample_interval == 0) {
+                if (latency_sample && sampled) {
                     latency_sample_end_time = tn.rdtsc();
-                    thread_param.latency.push_back(std::make_pair(latency_sample_start_time, latency_sample_end_time));
+                    thread_param.latency[op].record(latency_sample_end_time - latency_sample_start_time);
+                }
+                if (perf_counter && sampled) {
+                    thread_param.op_perf[op] += perf_counter->read_fast() - op_perf_begin;
+                    thread_param.op_perf_count[op]++;
+                }
+            };
+            // the worker's index calls allocate from the index arena, its own buffers are set up above
+            ArenaScope arena_scope(index_arena.get());
+            index->register_thread(&paramI);
+            // Warmup: lookups of bulk loaded keys that are neither timed nor counted, so cold caches
+            // and TLBs are not charged to the run
+            if ((warmup_ops > 0 || warmup_seconds > 0) && init_table_size > 0) {
+                uint64_t warmup_rng = random_seed + thread_id;
+                size_t warmup_num = warmup_ops / thread_num + (thread_id < warmup_ops % thread_num);
+                int64_t warmup_end = tn.rdtsc() + (int64_t) (warmup_seconds * 1e9 / tn.tsc_ghz_inv);
+                PAYLOAD_TYPE warmup_val;
+                for (size_t i = 0; warmup_seconds > 0 ? tn.rdtsc() < warmup_end : i < warmup_num; i++) {
+                    KEY_TYPE key = init_keys[(unsigned __int128) splitmix64(warmup_rng) * init_table_size >> 64];
+                    index->get(key, warmup_val, &paramI);
+                }
+            }
+            // waiting all thread ready
+            index->park_thread(&paramI);
+#pragma omp barrier
+            index->resume_thread(&paramI);
+#pragma omp master
+            start_time = tn.rdtsc();
+            intended_time = tn.rdtsc();
+            if (perf_counter) perf_begin = perf_counter->read();
+            // a phase with a duration stops every worker once it has passed
+            const int64_t deadline = tn.rdtsc() + (int64_t) (phase_seconds * 1e9 / tn.tsc_ghz_inv);
+            size_t deadline_check = 0;
+            bool expired = false;
+            auto past_deadline = [&]() {
+                if (phase_seconds > 0 && !expired && (++deadline_check & 255) == 0) expired = tn.rdtsc() > deadline;
+                return expired;
+            };
+// running benchmark
+            if (op_stream) {
+                OperationStream stream(*this, thread_id, thread_num);
+                Operation op;
+                KEY_TYPE key;
+                for (size_t i = 0; !past_deadline() && stream.next(op, key); i++) {
+                    do_operation(i, op, key, 0);
+                }
+                thread_param.insert_position = stream.insert_position();
+                thread_param.delete_position = stream.delete_position();
+            } else if (schedule == "partition") {
+                // one contiguous slice of the operation array per thread
+                size_t end = operations_num * (thread_id + 1) / thread_num;
+                for (size_t i = operations_num * thread_id / thread_num; i < end && !past_deadline(); i++) {
+                    do_operation(i, (Operation) ops[i].op, ops[i].key, ops[i].arg);
                 }
-            } // omp for loop
+            } else {
+#pragma omp for schedule(runtime) nowait
+                for (size_t i = 0; i < operations_num; i++) {
+                    if (past_deadline()) continue;
+                    do_operation(i, (Operation) ops[i].op, ops[i].key, ops[i].arg);
+                } // omp for loop
+            }
+            flush_batch();
+            // before waiting for the others, an idle registered thread may hold up their writes
+            index->unregister_thread(&paramI);
+            thread_param.finish_time = tn.rdtsc();
+            if (perf_counter) thread_param.run_perf = perf_counter->read() - perf_begin;
+#pragma omp barrier
 #pragma omp master
             end_time = tn.rdtsc();
+            delete[] scan_result;
+            thread_param.blob_checksum = blob_checksum;
         } // all thread join here
 
     //    });
+        for (auto c : op_copies) free_untouched(c, operations_num * sizeof(operation_t));
+        if (timeline_thread.joinable()) {
+            timeline_stop = true;
+            timeline_thread.join();
+            print_timeline(tn.tsc2ns(start_time), tn.tsc_ghz_inv);
+        }
         auto diff = tn.tsc2ns(end_time) - tn.tsc2ns(start_time);
         printf("Finish running\n");
+        stat.peak_rss = get_proc_memory("VmHWM");
+        for (auto &sample : timeline) {
+            stat.peak_arena_allocated = std::max(stat.peak_arena_allocated, sample.arena.allocated);
+        }
 
 
         // gather thread local variable
+        uint64_t executed_operations = 0;
         for (auto &p: params) {
+            executed_operations += p.operations;
             if (latency_sample) {
-                for (auto e : p.latency) {
-                    auto temp = (tn.tsc2ns(e.first) - tn.tsc2ns(e.second)) / (double) 1000000000;
-                    stat.latency.push_back(tn.tsc2ns(e.second) - tn.tsc2ns(e.first));
+                for (int op = 0; op < OPERATION_NUM; op++) {
+                    stat.op_latency[op].merge(p.latency[op]);
+                    stat.latency.merge(p.latency[op]);
                 }
             }
             stat.success_read += p.success_read;
@@ -386,54 +1317,197 @@ public:
             stat.success_update += p.success_update;
             stat.success_remove += p.success_remove;
             stat.scan_not_enough += p.scan_not_enough;
+            stat.run_perf += p.run_perf;
+            for (int op = 0; op < OPERATION_NUM; op++) {
+                stat.op_perf[op] += p.op_perf[op];
+                stat.op_perf_count[op] += p.op_perf_count[op];
+            }
+            stat.thread_time.push_back((tn.tsc2ns(p.finish_time) - tn.tsc2ns(start_time)) / (double) 1000000);
         }
+        index_keys += stat.success_insert - stat.success_remove;
+        stat.tsc_ns = tn.tsc_ghz_inv;
         // calculate throughput
-        stat.throughput = static_cast<uint64_t>(operations_num / (diff/(double) 1000000000));
+        stat.throughput = static_cast<uint64_t>(executed_operations / (diff/(double) 1000000000));
+        trial_throughput[phase_id].push_back(stat.throughput);
+        if (op_stream) {
+            // skip the keys some thread left unused, they are never inserted / deleted
+            for (auto &p: params) {
+                insert_cursor = std::max(insert_cursor, p.insert_position);
+                delete_cursor = std::max(delete_cursor, p.delete_position);
+            }
+        }
+        stat.operations = executed_operations;
 
         // calculate dataset metric
         if (dataset_statistic) {
-            std::sort(keys, keys + table_size);
-            stat.fitness_of_dataset = pgmMetric::PGM_metric(keys, table_size, error_bound);
+            if constexpr (std::is_arithmetic<KEY_TYPE>::value) {
+                std::sort(keys, keys + table_size);
+                stat.fitness_of_dataset = pgmMetric::PGM_metric(keys, table_size, error_bound);
+            } else {
+                COUT_THIS("[micro] dataset statistic needs numeric keys, try --string_encoding");
+            }
         }
 
         // record memory consumption
-        if (memory_record)
+        if (memory_record) {
             stat.memory_consumption = index->memory_consumption();
+            stat.arena = index_arena->stats();
+            stat.peak_arena_allocated = std::max(stat.peak_arena_allocated, stat.arena.allocated);
+        }
 
         print_stat();
 
         delete[] thread_array;
     }
 
-    void print_stat(bool header = false, bool clear_flag = true) {
-        double avg_latency = 0;
-        // average latency
-        for (auto t : stat.latency) {
-            avg_latency += t;
+    // Runs next to the workers and snapshots their operation counters, latency histograms, the
+    // key count of the index and the memory of the process and the index arena. The histograms
+    // and insert / remove counters are Relaxed, read while the workers write them, so a sample
+    // may be off by the few operations that were being recorded at that moment.
+    void sample_timeline(std::vector<param_t> &params, const TSCNS &tn, std::atomic<bool> &stop) {
+        timeline.clear();
+        LatencyHistogram last_latency;
+        auto next = std::chrono::steady_clock::now();
+        while (!stop.load()) {
+            next += std::chrono::milliseconds(timeline_interval);
+            std::this_thread::sleep_until(next);
+            TimelineSample sample;
+            sample.time = tn.rdns();
+            sample.operations = 0;
+            sample.keys = index_keys;
+            for (auto &p : params) {
+                sample.operations += p.operations.load(std::memory_order_relaxed);
+                sample.keys += p.success_insert.load();
+                sample.keys -= p.success_remove.load();
+                if (latency_sample) {
+                    for (auto &h : p.latency) sample.latency.merge(h);
+                }
+            }
+            sample.rss = get_proc_memory("VmRSS");
+            if (index_arena) sample.arena = index_arena->stats();
+            LatencyHistogram total_latency = sample.latency;
+            sample.latency.subtract(last_latency);
+            last_latency = total_latency;
+            timeline.push_back(sample);
         }
-        avg_latency /= stat.latency.size();
+    }
 
-        // latency variance
-        double latency_variance = 0;
-        if (latency_sample) {
-            for (auto t : stat.latency) {
-                latency_variance += (t - avg_latency) * (t - avg_latency);
+    void print_timeline(int64_t start_ns, double tsc_ns) {
+        if (!file_exists(timeline_path)) {
+            std::ofstream ofile;
+            ofile.open(timeline_path, std::ios::app);
+            ofile << "id" << ",";
+            ofile << "index_type" << ",";
+            ofile << "thread_num" << ",";
+            ofile << "time_ms" << ",";
+            ofile << "operations" << ",";
+            ofile << "throughput" << ",";
+            ofile << "50 percentile" << ",";
+            ofile << "99 percentile" << ",";
+            ofile << "99.9 percentile" << ",";
+            ofile << "keys" << ",";
+            ofile << "rss" << ",";
+            ofile << "arena_allocated" << ",";
+            ofile << "arena_active" << ",";
+            ofile << "arena_resident" << ",";
+            ofile << "bytes_per_key" << std::endl;
+        }
+
+        std::ofstream ofile;
+        ofile.open(timeline_path, std::ios::app);
+        int64_t last_time = start_ns;
+        uint64_t last_operations = 0;
+        for (auto &sample : timeline) {
+            if (sample.time <= start_ns) {
+                // before the workers started, only the histogram baseline matters
+                last_operations = sample.operations;
+                continue;
             }
-            latency_variance /= stat.latency.size();
-            std::sort(stat.latency.begin(), stat.latency.end());
+            ofile << run_id << ",";
+            ofile << index_type << ",";
+            ofile << thread_num << ",";
+            ofile << (sample.time - start_ns) / 1e6 << ",";
+            ofile << sample.operations << ",";
+            ofile << static_cast<uint64_t>((sample.operations - last_operations) * 1e9 / (sample.time - last_time)) << ",";
+            ofile << sample.latency.percentile(0.5) * tsc_ns << ",";
+            ofile << sample.latency.percentile(0.99) * tsc_ns << ",";
+            ofile << sample.latency.percentile(0.999) * tsc_ns << ",";
+            ofile << sample.keys << ",";
+            ofile << sample.rss << ",";
+            ofile << sample.arena.allocated << ",";
+            ofile << sample.arena.active << ",";
+            ofile << sample.arena.resident << ",";
+            ofile << (sample.keys ? (double) sample.arena.allocated / sample.keys : 0) << std::endl;
+            last_time = sample.time;
+            last_operations = sample.operations;
         }
+        ofile.close();
+    }
+
+    void print_stat(bool header = false, bool clear_flag = true) {
+        auto bulk_load_per_key = [&](int e) {
+            return init_keys.empty() ? 0 : stat.bulk_load_perf.value[e] / init_keys.size();
+        };
+        auto run_per_op = [&](int e) {
+            return stat.operations ? stat.run_perf.value[e] / stat.operations : 0;
+        };
+        auto op_per_op = [&](int op, int e) {
+            return stat.op_perf_count[op] ? stat.op_perf[op].value[e] / stat.op_perf_count[op] : 0;
+        };
+        double avg_latency = stat.latency.mean() * stat.tsc_ns;
+        double latency_variance = stat.latency.variance() * stat.tsc_ns * stat.tsc_ns;
+        auto latency_percentile = [&](const LatencyHistogram &h, double p) {
+            return h.percentile(p) * stat.tsc_ns;
+        };
+
+        // the statistics over the trials go on the last trial's row only, earlier rows leave them
+        // empty rather than report an interval over part of the trials
+        const bool trials_done = trial == repeat;
+        double throughput_mean, throughput_stddev, throughput_ci95;
+        mean_confidence(trial_throughput.empty() ? std::vector<double>() : trial_throughput[phase_id],
+                        throughput_mean, throughput_stddev, throughput_ci95);
 
         printf("Throughput = %llu\n", stat.throughput);
+        if (repeat > 1 && trials_done) {
+            printf("Throughput of trials 1-%zu = %.0f +- %.0f (95%% CI), stddev %.0f\n", trial,
+                   throughput_mean, throughput_ci95, throughput_stddev);
+        }
         printf("Memory: %lld\n", stat.memory_consumption);
+        if (memory_record) {
+            printf("Arena: allocated %lld, active %lld, resident %lld bytes\n", stat.arena.allocated,
+                   stat.arena.active, stat.arena.resident);
+        }
+        if (stat.peak_rss > 0) {
+            printf("Peak: rss %lld, arena allocated %lld bytes\n", stat.peak_rss, stat.peak_arena_allocated);
+        }
         printf("success_read: %llu\n", stat.success_read);
         printf("success_insert: %llu\n", stat.success_insert);
         printf("success_update: %llu\n", stat.success_update);
         printf("success_remove: %llu\n", stat.success_remove);
         printf("scan_not_enough: %llu\n", stat.scan_not_enough);
-
-        // time id
-        std::time_t t = std::time(nullptr);
-        char time_str[100];
+        if (latency_sample) {
+            for (int op = 0; op < OPERATION_NUM; op++) {
+                auto &h = stat.op_latency[op];
+                if (!h.count()) continue;
+                printf("%s latency (ns): count %llu, avg %.1f, p50 %.0f, p99 %.0f, p99.9 %.0f, max %.0f\n",
+                       operation_names[op], h.count(), h.mean() * stat.tsc_ns, latency_percentile(h, 0.5),
+                       latency_percentile(h, 0.99), latency_percentile(h, 0.999), h.max() * stat.tsc_ns);
+            }
+        }
+        if (perf) {
+            printf("per key of bulk load / per operation of run:");
+            for (int e = 0; e < PerfCounters::EVENT_NUM; e++) {
+                printf(" %s %.2f / %.2f", PerfCounters::event_names[e], bulk_load_per_key(e), run_per_op(e));
+            }
+            printf("\n");
+        }
+        printf("thread finish time (ms):");
+        for (auto t : stat.thread_time) {
+            printf(" %.2f", t);
+        }
+        printf("\n");
+        double min_thread_time = stat.thread_time.empty() ? 0 : *std::min_element(stat.thread_time.begin(), stat.thread_time.end());
+        double max_thread_time = stat.thread_time.empty() ? 0 : *std::max_element(stat.thread_time.begin(), stat.thread_time.end());
 
         if (!file_exists(output_path)) {
             std::ofstream ofile;
@@ -461,14 +1535,64 @@ public:
             ofile << "data_shift" << ",";
             ofile << "pgm" << ",";
             ofile << "error_bound" ",";
-            ofile << "table_size" << std::endl;
+            ofile << "table_size" << ",";
+            ofile << "schedule" << ",";
+            ofile << "min_thread_time" << ",";
+            ofile << "max_thread_time" << ",";
+            ofile << "target_qps" << ",";
+            ofile << "bulk_load_time" << ",";
+            ofile << "bulk_load_throughput" << ",";
+            ofile << "bulk_load_memory" << ",";
+            ofile << "batch_size" << ",";
+            ofile << "interleave" << ",";
+            ofile << "dispatch" << ",";
+            ofile << "pin" << ",";
+            ofile << "numa" << ",";
+            ofile << "numa_nodes" << ",";
+            ofile << "cpus" << ",";
+            ofile << "warmup_ops" << ",";
+            ofile << "warmup_seconds" << ",";
+            ofile << "trial" << ",";
+            ofile << "throughput_mean" << ",";
+            ofile << "throughput_stddev" << ",";
+            ofile << "throughput_ci95" << ",";
+            ofile << "phase" << ",";
+            ofile << "rmw" << ",";
+            ofile << "phase_seconds" << ",";
+            ofile << "replay_trace" << ",";
+            ofile << "key_type" << ",";
+            ofile << "string_encoding" << ",";
+            ofile << "payload_size" << ",";
+            ofile << "blob_size" << ",";
+            ofile << "distribution" << ",";
+            ofile << "arena_allocated" << ",";
+            ofile << "arena_active" << ",";
+            ofile << "arena_resident" << ",";
+            ofile << "peak_rss" << ",";
+            ofile << "peak_arena_allocated";
+            for (auto name : operation_names) {
+                ofile << "," << name << "_count";
+                ofile << "," << name << "_avg";
+                ofile << "," << name << "_50 percentile";
+                ofile << "," << name << "_99 percentile";
+                ofile << "," << name << "_99.9 percentile";
+                ofile << "," << name << "_max";
+            }
+            for (auto event : PerfCounters::event_names) {
+                ofile << "," << "bulk_load_" << event << "_per_key";
+                ofile << "," << "run_" << event << "_per_op";
+            }
+            for (auto name : operation_names) {
+                for (auto event : PerfCounters::event_names) {
+                    ofile << "," << name << "_" << event;
+                }
+            }
+            ofile << std::endl;
         }
 
         std::ofstream ofile;
         ofile.open(output_path, std::ios::app);
-        if (std::strftime(time_str, sizeof(time_str), "%Y%m%d%H%M%S", std::localtime(&t))) {
-            ofile << time_str << ',';
-        }
+        ofile << run_id << ',';
         ofile << read_ratio << "," << insert_ratio << "," << update_ratio << "," << scan_ratio << "," << delete_ratio << ",";
 
         ofile << keys_file_path << ",";
@@ -478,13 +1602,13 @@ public:
         ofile << stat.memory_consumption << ",";
         ofile << thread_num << ",";
         if (latency_sample) {
-            ofile << stat.latency[0] << ",";
-            ofile << stat.latency[0.5 * stat.latency.size()] << ",";
-            ofile << stat.latency[0.9 * stat.latency.size()] << ",";
-            ofile << stat.latency[0.99 * stat.latency.size()] << ",";
-            ofile << stat.latency[0.999 * stat.latency.size()] << ",";
-            ofile << stat.latency[0.9999 * stat.latency.size()] << ",";
-            ofile << stat.latency[stat.latency.size() - 1] << ",";
+            ofile << stat.latency.min() * stat.tsc_ns << ",";
+            ofile << latency_percentile(stat.latency, 0.5) << ",";
+            ofile << latency_percentile(stat.latency, 0.9) << ",";
+            ofile << latency_percentile(stat.latency, 0.99) << ",";
+            ofile << latency_percentile(stat.latency, 0.999) << ",";
+            ofile << latency_percentile(stat.latency, 0.9999) << ",";
+            ofile << stat.latency.max() * stat.tsc_ns << ",";
             ofile << avg_latency << ",";
         } else {
             ofile << 0 << ",";
@@ -503,7 +1627,63 @@ public:
         ofile << data_shift << ",";
         ofile << stat.fitness_of_dataset << ",";
         ofile << error_bound << ",";
-        ofile << table_size << std::endl;
+        ofile << table_size << ",";
+        ofile << (op_stream ? "stream" : schedule) << ",";
+        ofile << min_thread_time << ",";
+        ofile << max_thread_time << ",";
+        ofile << target_qps << ",";
+        ofile << stat.bulk_load_time << ",";
+        ofile << stat.bulk_load_throughput << ",";
+        ofile << stat.bulk_load_memory << ",";
+        ofile << batch_size << ",";
+        ofile << interleave << ",";
+        ofile << (virtual_dispatch ? "virtual" : "static") << ",";
+        ofile << (pin == "none" || pin == "compact" || pin == "scatter" ? pin : "list") << ",";
+        ofile << (numa_active ? numa : "none") << ",";
+        ofile << topology.node_num << ",";
+        ofile << pinned_cpus() << ",";
+        ofile << warmup_ops << ",";
+        ofile << warmup_seconds << ",";
+        ofile << trial << ",";
+        if (trials_done) {
+            ofile << throughput_mean << ",";
+            ofile << throughput_stddev << ",";
+            ofile << throughput_ci95 << ",";
+        } else {
+            ofile << ",,,";
+        }
+        ofile << phases[phase_id].name << ",";
+        ofile << rmw_ratio << ",";
+        ofile << phase_seconds << ",";
+        ofile << replay_trace << ",";
+        ofile << key_type << ",";
+        ofile << string_encoding << ",";
+        ofile << payload_size << ",";
+        ofile << blob_size << ",";
+        ofile << distribution_name() << ",";
+        ofile << stat.arena.allocated << ",";
+        ofile << stat.arena.active << ",";
+        ofile << stat.arena.resident << ",";
+        ofile << stat.peak_rss << ",";
+        ofile << stat.peak_arena_allocated;
+        for (auto &h : stat.op_latency) {
+            ofile << "," << h.count();
+            ofile << "," << h.mean() * stat.tsc_ns;
+            ofile << "," << latency_percentile(h, 0.5);
+            ofile << "," << latency_percentile(h, 0.99);
+            ofile << "," << latency_percentile(h, 0.999);
+            ofile << "," << h.max() * stat.tsc_ns;
+        }
+        for (int e = 0; e < PerfCounters::EVENT_NUM; e++) {
+            ofile << "," << bulk_load_per_key(e);
+            ofile << "," << run_per_op(e);
+        }
+        for (int op = 0; op < OPERATION_NUM; op++) {
+            for (int e = 0; e < PerfCounters::EVENT_NUM; e++) {
+                ofile << "," << op_per_op(op, e);
+            }
+        }
+        ofile << std::endl;
         ofile.close();
 
         if (clear_flag) stat.clear();
@@ -511,15 +1691,63 @@ public:
 
     void run_benchmark() {
         load_keys();
-        generate_operations(keys);
+        if (bulkload_only) {
+            for (auto s: all_index_type) {
+                for (auto t: all_thread_num) {
+                    thread_num = stoi(t);
+                    index_type = s;
+                    index_t *index;
+                    prepare(index, keys);
+                    if (memory_record) {
+                        stat.memory_consumption = index->memory_consumption();
+                        stat.arena = index_arena->stats();
+                    }
+                    print_stat();
+                    if (index != nullptr) delete index;
+                }
+            }
+            return;
+        }
+        shift_keys(keys);
+        trace_recorded.assign(phases.size(), false);
+        if (!replay_trace.empty()) {
+            max_scan_num = std::max(scan_num, map_replay_trace());
+            phases[0].operations_num = operations_num;
+        } else if (phases.size() == 1) {
+            // a single phase is generated once and replayed on every index
+            apply_phase(phases[0], 1, 1);
+            reset_cursors();
+            generate_operations(keys);
+            phases[0].operations_num = operations_num;  // fewer if the insert / delete keys ran out
+        }
         for (auto s: all_index_type) {
             for (auto t: all_thread_num) {
-                thread_num = stoi(t);
                 index_type = s;
-                index_t *index;
-                prepare(index, keys);
-                run(index);
-                if (index != nullptr) delete index;
+                // open-loop runs sweep every target rate on a fresh index
+                std::vector <std::string> qps_sweep = all_target_qps.empty() ? std::vector<std::string>{"0"} : all_target_qps;
+                for (auto q: qps_sweep) {
+                    target_qps = stod(q);
+                    trial_throughput.assign(phases.size(), std::vector<double>());
+                    for (trial = 1; trial <= repeat; trial++) {
+                        // the index is created for the most threads any phase runs with
+                        thread_num = 0;
+                        for (auto &phase: phases) {
+                            thread_num = std::max<size_t>(thread_num, phase.thread_num ? phase.thread_num : stoi(t));
+                        }
+                        index_t *index;
+                        prepare(index, keys);
+                        size_t index_thread_num = thread_num;
+                        reset_cursors();
+                        // the phases run one after another on the same index
+                        for (phase_id = 0; phase_id < phases.size(); phase_id++) {
+                            apply_phase(phases[phase_id], stoi(t), index_thread_num);
+                            if (phases.size() > 1) generate_operations(keys);
+                            run(index);
+                        }
+                        phase_id = 0;
+                        if (index != nullptr) delete index;
+                    }
+                }
             }
         }
     }
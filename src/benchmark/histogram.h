@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// A counter that one thread writes and others may read while it runs: relaxed atomic loads and
+// stores cost what plain ones do, and make those reads well defined. Updates are a load and a
+// store, so there must be a single writer.
+template<class T>
+class Relaxed {
+public:
+    Relaxed(T value = T()) : value(value) {}
+
+    Relaxed(const Relaxed &other) : value(other.load()) {}
+
+    Relaxed &operator=(const Relaxed &other) {
+        store(other.load());
+        return *this;
+    }
+
+    T load() const { return value.load(std::memory_order_relaxed); }
+
+    void store(T v) { value.store(v, std::memory_order_relaxed); }
+
+    operator T() const { return load(); }
+
+    Relaxed &operator+=(T v) {
+        store(load() + v);
+        return *this;
+    }
+
+    Relaxed &operator-=(T v) {
+        store(load() - v);
+        return *this;
+    }
+
+private:
+    std::atomic<T> value;
+};
+
+// Log-linear latency histogram in the spirit of HdrHistogram. Values below 2^(SUB_BITS + 1)
+// are counted exactly, larger values keep SUB_BITS bits of precision (< 1.6% relative error).
+// Recording is a couple of instructions and a counter increment, so every operation can be
+// timed. A histogram is written by one thread and merged into a global one after the run; its
+// counters are Relaxed so that the timeline sampler can merge it while the thread records.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 6;
+    static constexpr uint64_t SUB_COUNT = 1ull << SUB_BITS;
+    static constexpr size_t BUCKET_NUM = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    LatencyHistogram() : counts(BUCKET_NUM, 0) {}
+
+    inline void record(uint64_t value) {
+        counts[bucket_of(value)] += 1;
+        total += 1;
+        sum += value;
+        sum_square += (double) value * value;
+        if (value < min_value) min_value.store(value);
+        if (value > max_value) max_value.store(value);
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for (size_t i = 0; i < BUCKET_NUM; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        sum_square += other.sum_square;
+        min_value.store(std::min(min_value.load(), other.min_value.load()));
+        max_value.store(std::max(max_value.load(), other.max_value.load()));
+    }
+
+    // Turn a later snapshot of the same histogram into the window since other was taken.
+    // min and max become the bounds of the window's lowest and highest occupied buckets.
+    void subtract(const LatencyHistogram &other) {
+        size_t first = BUCKET_NUM, last = 0;
+        for (size_t i = 0; i < BUCKET_NUM; i++) {
+            counts[i] -= other.counts[i];
+            if (counts[i]) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+        total -= other.total;
+        sum -= other.sum;
+        sum_square -= other.sum_square;
+        min_value.store(first < BUCKET_NUM ? value_of(first) : UINT64_MAX);
+        max_value.store(first < BUCKET_NUM ? value_of(last) : 0);
+    }
+
+    void clear() {
+        for (auto &count : counts) count.store(0);
+        total.store(0);
+        sum.store(0);
+        sum_square.store(0);
+        min_value.store(UINT64_MAX);
+        max_value.store(0);
+    }
+
+    uint64_t count() const { return total; }
+
+    uint64_t min() const { return total ? min_value.load() : 0; }
+
+    uint64_t max() const { return max_value; }
+
+    double mean() const { return total ? (double) sum / total : 0; }
+
+    double variance() const {
+        if (!total) return 0;
+        double avg = mean();
+        return sum_square / total - avg * avg;
+    }
+
+    // The value below which a fraction p of the recorded values fall, clamped to [min, max]
+    uint64_t percentile(double p) const {
+        if (!total) return 0;
+        uint64_t rank = std::min<uint64_t>(p * total, total - 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_NUM; i++) {
+            seen += counts[i];
+            if (seen > rank) {
+                return std::max(min_value.load(), std::min(max_value.load(), value_of(i)));
+            }
+        }
+        return max_value;
+    }
+
+private:
+    // shift = 0 covers [0, 2 * SUB_COUNT) exactly, shift = k > 0 covers
+    // [SUB_COUNT << k, 2 * SUB_COUNT << k) in SUB_COUNT buckets
+    static inline size_t bucket_of(uint64_t value) {
+        int msb = 63 - __builtin_clzll(value | 1);
+        int shift = msb > SUB_BITS ? msb - SUB_BITS : 0;
+        return shift * SUB_COUNT + (value >> shift);
+    }
+
+    // midpoint of the bucket
+    static inline uint64_t value_of(size_t bucket) {
+        int shift = bucket < 2 * SUB_COUNT ? 0 : bucket / SUB_COUNT - 1;
+        uint64_t low = (bucket - shift * SUB_COUNT) << shift;
+        return low + ((1ull << shift) >> 1);
+    }
+
+    std::vector<Relaxed<uint64_t>> counts;
+    Relaxed<uint64_t> total = 0;
+    Relaxed<uint64_t> sum = 0;
+    Relaxed<double> sum_square = 0;
+    Relaxed<uint64_t> min_value = UINT64_MAX;
+    Relaxed<uint64_t> max_value = 0;
+};
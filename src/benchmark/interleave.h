@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// Interleaved execution of independent lookups (asynchronous memory access chaining). A
+// lookup is written as a resumable task: step(task, i) advances lookup i to its next likely
+// cache miss, prefetches it and returns false, or finishes it and returns true. The executor
+// keeps up to `group` tasks in flight and switches to the next one at every step, so one
+// thread has several misses outstanding instead of stalling on each node hop in turn.
+// Task must be default constructible into its initial state.
+static constexpr size_t MAX_INTERLEAVE = 64;
+
+template<class Task, class Step>
+inline void run_interleaved(size_t num, size_t group, Step step) {
+    group = std::max<size_t>(1, std::min(group, MAX_INTERLEAVE));
+    Task tasks[MAX_INTERLEAVE];
+    size_t ids[MAX_INTERLEAVE];
+    size_t next = 0, active = 0;
+    for (; active < group && next < num; active++) {
+        ids[active] = next++;
+    }
+    size_t s = 0;
+    while (active > 0) {
+        if (!step(tasks[s], ids[s])) {
+            s++;
+        } else if (next < num) {
+            tasks[s] = Task();
+            ids[s] = next++;
+            s++;
+        } else {
+            // retire the slot, the last in-flight task takes its place
+            active--;
+            tasks[s] = tasks[active];
+            ids[s] = ids[active];
+        }
+        if (s >= active) s = 0;
+    }
+}
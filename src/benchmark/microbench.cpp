@@ -1,8 +1,43 @@
 #include "./benchmark.h"
 
-int main(int argc, char **argv) {
-    Benchmark <uint64_t, uint64_t> bench;
+template<typename KEY_TYPE, typename PAYLOAD_TYPE>
+void run_microbench(int argc, char **argv) {
+    Benchmark <KEY_TYPE, PAYLOAD_TYPE> bench;
     bench.parse_args(argc, argv);
     bench.run_benchmark();
 }
 
+int main(int argc, char **argv) {
+    // every key and payload type is a separate instantiation of the benchmark and the indexes,
+    // so wider payloads are only built for u64 keys
+    auto flags = parse_flags(argc, argv);
+    auto key_type = get_with_default(flags, "key_type", "u64");
+    auto payload_size = get_with_default(flags, "payload_size", "8");
+    if (payload_size != "8" && key_type != "u64") {
+        std::cout << "--payload_size " << payload_size << " needs --key_type=u64.\n";
+        return 0;
+    }
+    if (key_type == "u64") {
+        if (payload_size == "8") {
+            run_microbench<uint64_t, uint64_t>(argc, argv);
+        } else if (payload_size == "16") {
+            run_microbench<uint64_t, Payload<16>>(argc, argv);
+        } else if (payload_size == "32") {
+            run_microbench<uint64_t, Payload<32>>(argc, argv);
+        } else {
+            std::cout << "Unknown payload size " << payload_size << ", use 8, 16 or 32 (or --blob_size).\n";
+            return 0;
+        }
+    } else if (key_type == "u32") {
+        run_microbench<uint32_t, uint64_t>(argc, argv);
+    } else if (key_type == "i64") {
+        run_microbench<int64_t, uint64_t>(argc, argv);
+    } else if (key_type == "f64") {
+        run_microbench<double, uint64_t>(argc, argv);
+    } else if (key_type == "str") {
+        run_microbench<StringKey, uint64_t>(argc, argv);
+    } else {
+        std::cout << "Unknown key type " << key_type << ", use u32, u64, i64, f64 or str.\n";
+        return 0;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "topology.h"
+
+// Inline record payload of SIZE bytes for --payload_size. A payload is written whole, with
+// every word set to the value, and reads back as its first word, so the benchmark can treat it
+// like the default uint64_t payload while the index moves SIZE bytes per record.
+template<size_t SIZE>
+struct Payload {
+    static_assert(SIZE >= sizeof(uint64_t) && SIZE % sizeof(uint64_t) == 0, "payloads are whole words");
+
+    uint64_t words[SIZE / sizeof(uint64_t)];
+
+    Payload() = default;
+
+    Payload(uint64_t value) {
+        for (auto &word : words) word = value;
+    }
+
+    operator uint64_t() const { return words[0]; }
+
+    Payload &operator+=(uint64_t value) {
+        words[0] += value;
+        return *this;
+    }
+};
+
+// Bump allocator for out-of-line values (--blob_size): the index payload is the address of
+// a blob. Every worker allocates from its own arena. Blobs are never freed one by one, they
+// go away with the arena, which lives as long as the index. Chunks are mapped directly, so
+// they do not show up in the malloc statistics of an index arena, and their pages land on the
+// node of the worker that writes them.
+class ValueArena {
+public:
+    explicit ValueArena(size_t blob_size)
+            : blob_size(blob_size), chunk_size(std::max(CHUNK_SIZE, blob_size)) {}
+
+    char *alloc() {
+        if (chunks.empty() || used + blob_size > chunk_size) {
+            chunks.emplace_back(static_cast<char *>(alloc_untouched(chunk_size)), Unmap{chunk_size});
+            used = 0;
+        }
+        char *blob = chunks.back().get() + used;
+        used += blob_size;
+        return blob;
+    }
+
+    // Fill a blob with value and return its address as the index payload
+    uint64_t make(uint64_t value) {
+        auto *blob = reinterpret_cast<uint64_t *>(alloc());
+        for (size_t i = 0; i < blob_size / sizeof(uint64_t); i++) blob[i] = value;
+        return reinterpret_cast<uint64_t>(blob);
+    }
+
+    // Read a whole blob back, returning its first word
+    static uint64_t read(uint64_t payload, size_t blob_size, uint64_t &checksum) {
+        auto *blob = reinterpret_cast<const uint64_t *>(payload);
+        for (size_t i = 0; i < blob_size / sizeof(uint64_t); i++) checksum += blob[i];
+        return blob[0];
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 2 << 20;
+
+    struct Unmap {
+        size_t bytes;
+
+        void operator()(char *p) const { free_untouched(p, bytes); }
+    };
+
+    size_t blob_size;
+    size_t chunk_size;
+    size_t used = 0;
+    std::vector<std::unique_ptr<char, Unmap>> chunks;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+
+// Hardware and software event counters of the calling thread, opened through perf_event_open.
+// Only user space is counted, so this also works with kernel.perf_event_paranoid = 2. Events
+// the machine does not support (e.g. in a VM without a PMU) are skipped and read as 0.
+class PerfCounters {
+public:
+    enum Event {
+        CYCLES = 0, INSTRUCTIONS, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, PAGE_FAULTS, EVENT_NUM
+    };
+    static constexpr const char *event_names[EVENT_NUM] = {
+            "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses", "page_faults"
+    };
+
+    struct Values {
+        double value[EVENT_NUM] = {0};
+
+        Values &operator+=(const Values &other) {
+            for (int e = 0; e < EVENT_NUM; e++) value[e] += other.value[e];
+            return *this;
+        }
+
+        Values operator-(const Values &other) const {
+            Values diff;
+            for (int e = 0; e < EVENT_NUM; e++) diff.value[e] = value[e] - other.value[e];
+            return diff;
+        }
+    };
+
+    PerfCounters() {
+        static const uint32_t types[EVENT_NUM] = {
+                PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE
+        };
+        static const uint64_t configs[EVENT_NUM] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_PAGE_FAULTS
+        };
+        for (int e = 0; e < EVENT_NUM; e++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[e];
+            attr.config = configs[e];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fd[e] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+            page[e] = nullptr;
+            if (fd[e] < 0) continue;
+            // the first page exposes the counter index for rdpmc
+            void *addr = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd[e], 0);
+            if (addr != MAP_FAILED) page[e] = static_cast<struct perf_event_mmap_page *>(addr);
+        }
+    }
+
+    ~PerfCounters() {
+        for (int e = 0; e < EVENT_NUM; e++) {
+            if (page[e]) munmap(page[e], sysconf(_SC_PAGESIZE));
+            if (fd[e] >= 0) close(fd[e]);
+        }
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available(int e) const { return fd[e] >= 0; }
+
+    // Cumulative counts, scaled up when the kernel had to multiplex the counters
+    Values read() const {
+        Values values;
+        for (int e = 0; e < EVENT_NUM; e++) {
+            uint64_t buf[3];
+            if (fd[e] < 0 || ::read(fd[e], buf, sizeof(buf)) != sizeof(buf)) continue;
+            values.value[e] = buf[2] ? (double) buf[0] * buf[1] / buf[2] : 0;
+        }
+        return values;
+    }
+
+    // Unscaled cumulative counts for short intervals such as a single operation. Hardware
+    // events are read with rdpmc, without a system call, when the kernel allows it.
+    Values read_fast() const {
+        Values values;
+        for (int e = 0; e < EVENT_NUM; e++) {
+            if (fd[e] >= 0) values.value[e] = read_raw(e);
+        }
+        return values;
+    }
+
+private:
+    uint64_t read_raw(int e) const {
+        const struct perf_event_mmap_page *pc = page[e];
+        if (pc && pc->cap_user_rdpmc) {
+            uint32_t seq, index;
+            uint64_t count;
+            do {
+                seq = pc->lock;
+                asm volatile("" : : : "memory");
+                index = pc->index;
+                count = pc->offset;
+                if (index) {
+                    int64_t pmc = __builtin_ia32_rdpmc(index - 1);
+                    int shift = 64 - pc->pmc_width;
+                    count += (pmc << shift) >> shift;
+                }
+                asm volatile("" : : : "memory");
+            } while (pc->lock != seq);
+            if (index) return count;
+        }
+        uint64_t buf[3];
+        if (::read(fd[e], buf, sizeof(buf)) != sizeof(buf)) return 0;
+        return buf[0];
+    }
+
+    int fd[EVENT_NUM];
+    struct perf_event_mmap_page *page[EVENT_NUM];
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "utils.h"
+#include "zipf.h"
+
+// Where the reads, updates, scans and read-modify-writes of a phase go (--sample_distribution).
+// Positions index the sorted bulk loaded keys, except for latest, whose positions are ranks
+// counted back from the most recently inserted key.
+//   uniform     every bulk loaded key alike
+//   zipf        zipfian with zipf_theta, the popular keys hashed over the key space
+//   hotspot     hot_ops of the accesses on a contiguous range of hot_keys keys, the rest uniform
+//   latest      zipfian with zipf_theta over the insertion order, newest keys most popular
+//   sequential  a walk over the keys in order that wraps around
+struct KeyDistribution {
+    enum Kind {
+        UNIFORM, ZIPF, HOTSPOT, LATEST, SEQUENTIAL
+    };
+
+    Kind kind = UNIFORM;
+    size_t num_keys = 0;
+    double zipf_theta = 0.99;
+    double zetan = 0;  // zeta(num_keys, zipf_theta), for zipf and latest
+    size_t hot_begin = 0;
+    size_t hot_keys = 0;
+    double hot_ops = 0;
+
+    static bool parse(const std::string &name, Kind &kind) {
+        static const char *names[] = {"uniform", "zipf", "hotspot", "latest", "sequential"};
+        for (int k = UNIFORM; k <= SEQUENTIAL; k++) {
+            if (name == names[k]) {
+                kind = static_cast<Kind>(k);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Draws positions from a KeyDistribution. Sequential walks start at start.
+class KeySampler {
+public:
+    KeySampler(const KeyDistribution &dist, uint64_t seed, size_t start = 0)
+            : dist(dist), rng(seed), position(dist.num_keys ? start % dist.num_keys : 0),
+              zipf(dist.num_keys, dist.zipf_theta, dist.zetan, seed) {}
+
+    inline size_t next() {
+        switch (dist.kind) {
+            case KeyDistribution::ZIPF:
+                return zipf.nextValue();
+            case KeyDistribution::LATEST:
+                return zipf.ZipfianGenerator::nextValue();
+            case KeyDistribution::HOTSPOT: {
+                size_t cold_keys = dist.num_keys - dist.hot_keys;
+                if (cold_keys == 0 || (splitmix64(rng) >> 11) * 0x1.0p-53 < dist.hot_ops) {
+                    return dist.hot_begin + below(dist.hot_keys);
+                }
+                size_t cold = below(cold_keys);
+                return cold < dist.hot_begin ? cold : cold + dist.hot_keys;
+            }
+            case KeyDistribution::SEQUENTIAL: {
+                size_t pos = position;
+                if (++position == dist.num_keys) position = 0;
+                return pos;
+            }
+            default:
+                return below(dist.num_keys);
+        }
+    }
+
+private:
+    inline size_t below(size_t n) { return (unsigned __int128) splitmix64(rng) * n >> 64; }
+
+    const KeyDistribution &dist;
+    uint64_t rng;
+    size_t position;
+    ScrambledZipfianGenerator zipf;
+};
+
+// Draw count positions in parallel. Every block of positions has its own sampler, seeded by
+// the block number and starting its walk where the block starts, so the positions do not
+// depend on the number of threads.
+inline size_t *sample_positions(const KeyDistribution &dist, size_t count, uint64_t seed) {
+    const size_t block = 1 << 16;
+    auto *positions = new size_t[count];
+#pragma omp parallel for schedule(dynamic)
+    for (size_t b = 0; b < (count + block - 1) / block; b++) {
+        uint64_t block_seed = seed * 0x9E3779B97F4A7C15ull + b;
+        KeySampler sampler(dist, splitmix64(block_seed), b * block);
+        for (size_t i = b * block; i < std::min(count, (b + 1) * block); i++) {
+            positions[i] = sampler.next();
+        }
+    }
+    return positions;
+}
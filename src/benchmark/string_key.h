@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// A string key of up to MAX_STRING_KEY_LEN bytes, stored inline and zero padded so that arrays
+// of keys, operations and trace records keep a fixed stride. Keys must not contain NUL bytes:
+// the padding then sorts a key before its extensions and NUL-terminates it.
+static constexpr size_t MAX_STRING_KEY_LEN = 30;
+
+struct StringKey {
+    char data[MAX_STRING_KEY_LEN + 1] = {};
+    uint8_t len = 0;
+
+    StringKey() = default;
+
+    // longer strings are truncated to MAX_STRING_KEY_LEN bytes
+    StringKey(const char *s, size_t n) : len(std::min(n, MAX_STRING_KEY_LEN)) {
+        memcpy(data, s, len);
+    }
+
+    std::string str() const { return std::string(data, len); }
+
+    // with the zero padding a fixed size memcmp is the lexicographic order
+    bool operator<(const StringKey &other) const { return memcmp(data, other.data, sizeof(data)) < 0; }
+    bool operator>(const StringKey &other) const { return other < *this; }
+    bool operator<=(const StringKey &other) const { return !(other < *this); }
+    bool operator>=(const StringKey &other) const { return !(*this < other); }
+    bool operator==(const StringKey &other) const { return memcmp(data, other.data, sizeof(data)) == 0; }
+    bool operator!=(const StringKey &other) const { return !(*this == other); }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const StringKey &key) {
+    return os << key.str();
+}
+
+// The bytes of a key in the order the byte-comparing indexes (ART, HOT, Masstree, Wormhole) sort
+// by: unsigned integers big-endian, string keys with their NUL terminator so that no key is a
+// prefix of another. Refers to the key it was made from.
+template<class KEY_TYPE>
+struct KeyBytes {
+    static_assert(std::is_integral<KEY_TYPE>::value && std::is_unsigned<KEY_TYPE>::value,
+                  "only unsigned integers sort by their bytes");
+
+    explicit KeyBytes(KEY_TYPE key) {
+        if constexpr (sizeof(KEY_TYPE) == 8) {
+            value = __builtin_bswap64(key);
+        } else if constexpr (sizeof(KEY_TYPE) == 4) {
+            value = __builtin_bswap32(key);
+        } else if constexpr (sizeof(KEY_TYPE) == 2) {
+            value = __builtin_bswap16(key);
+        } else {
+            value = key;
+        }
+    }
+
+    const char *data() const { return reinterpret_cast<const char *>(&value); }
+
+    size_t size() const { return sizeof(value); }
+
+    KEY_TYPE value;
+};
+
+template<>
+struct KeyBytes<StringKey> {
+    explicit KeyBytes(const StringKey &key) : key(key) {}
+
+    const char *data() const { return key.data; }
+
+    size_t size() const { return key.len + 1; }
+
+    const StringKey &key;
+};
+
+// Inverse of KeyBytes, for indexes that hand back the stored bytes
+template<class KEY_TYPE>
+KEY_TYPE key_from_bytes(const char *bytes, size_t size) {
+    if constexpr (std::is_same<KEY_TYPE, StringKey>::value) {
+        return StringKey(bytes, size ? size - 1 : 0);
+    } else {
+        KEY_TYPE value;
+        memcpy(&value, bytes, sizeof(value));
+        return KeyBytes<KEY_TYPE>(value).value;
+    }
+}
+
+// A key no smaller than any other, to bound a range that should only stop at its count
+template<class KEY_TYPE>
+KEY_TYPE max_key() {
+    if constexpr (std::is_same<KEY_TYPE, StringKey>::value) {
+        StringKey key;
+        memset(key.data, 0xff, MAX_STRING_KEY_LEN);
+        key.len = MAX_STRING_KEY_LEN;
+        return key;
+    } else {
+        return std::numeric_limits<KEY_TYPE>::max();
+    }
+}
+
+// Order-preserving 64-bit code of a string key for indexes that need numeric keys: its first
+// 8 bytes read big-endian. Keys that only differ after them get the same code.
+inline uint64_t prefix_code(const StringKey &key) {
+    uint64_t code;
+    memcpy(&code, key.data, sizeof(code));
+    return __builtin_bswap64(code);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Parse a kernel style cpu/node list such as "0-3,8,10-11"
+inline std::vector<int> parse_id_list(const std::string &list) {
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int id = first; id <= last; id++) ids.push_back(id);
+    }
+    return ids;
+}
+
+// CPUs and NUMA nodes of the machine from sysfs, restricted to the CPUs the process may run on.
+// Without NUMA information (no /sys/devices/system/node) everything is on node 0.
+class Topology {
+public:
+    struct Cpu {
+        int id;
+        int node;
+        int package;
+        int core;
+    };
+
+    Topology() {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        for (int id = 0; id < CPU_SETSIZE; id++) {
+            if (!CPU_ISSET(id, &allowed)) continue;
+            std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            cpus.push_back({id, 0, read_int(dir + "physical_package_id"), read_int(dir + "core_id")});
+        }
+        auto nodes = parse_id_list(read_line("/sys/devices/system/node/online"));
+        for (int node : nodes) {
+            auto node_cpus = parse_id_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+            for (auto &cpu : cpus) {
+                if (std::find(node_cpus.begin(), node_cpus.end(), cpu.id) != node_cpus.end()) cpu.node = node;
+            }
+        }
+        node_num = nodes.empty() ? 1 : *std::max_element(nodes.begin(), nodes.end()) + 1;
+    }
+
+    int node_of(int cpu) const {
+        for (auto &c : cpus) {
+            if (c.id == cpu) return c.node;
+        }
+        return 0;
+    }
+
+    // Worker CPUs in placement order. compact fills the hyperthreads of a core, then the cores of
+    // a socket and node, before moving on; scatter alternates nodes and takes one hyperthread of
+    // every core before the second ones. Anything else is an explicit cpu list.
+    std::vector<int> placement(const std::string &spec) const {
+        std::vector<Cpu> order = cpus;
+        if (spec == "compact") {
+            std::sort(order.begin(), order.end(), [](const Cpu &a, const Cpu &b) {
+                return std::tie(a.node, a.package, a.core, a.id) < std::tie(b.node, b.package, b.core, b.id);
+            });
+        } else if (spec == "scatter") {
+            // rank of every cpu among the hyperthreads of its core
+            std::vector<std::pair<int, Cpu>> ranked;
+            for (auto &cpu : order) {
+                int smt = 0;
+                for (auto &other : ranked) {
+                    smt += other.second.package == cpu.package && other.second.core == cpu.core;
+                }
+                ranked.emplace_back(smt, cpu);
+            }
+            std::sort(ranked.begin(), ranked.end(), [](const std::pair<int, Cpu> &a, const std::pair<int, Cpu> &b) {
+                return std::tie(a.first, a.second.package, a.second.core, a.second.id) <
+                       std::tie(b.first, b.second.package, b.second.core, b.second.id);
+            });
+            std::vector<std::vector<Cpu>> per_node(node_num);
+            for (auto &r : ranked) per_node[r.second.node].push_back(r.second);
+            order.clear();
+            for (size_t round = 0; order.size() < cpus.size(); round++) {
+                for (auto &node_cpus : per_node) {
+                    if (round < node_cpus.size()) order.push_back(node_cpus[round]);
+                }
+            }
+        } else {
+            return parse_id_list(spec);
+        }
+        std::vector<int> ids;
+        for (auto &cpu : order) ids.push_back(cpu.id);
+        return ids;
+    }
+
+    std::vector<Cpu> cpus;
+    int node_num = 1;
+
+private:
+    static std::string read_line(const std::string &path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    static int read_int(const std::string &path) {
+        std::string line = read_line(path);
+        return line.empty() ? 0 : std::stoi(line);
+    }
+};
+
+// Pin the calling thread to one cpu
+inline bool pin_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Interleave the future allocations of the calling thread over the first node_num nodes
+inline bool interleave_memory(int node_num) {
+    unsigned long mask = node_num >= 64 ? ~0ul : (1ul << node_num) - 1;
+    return syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8) == 0;
+}
+
+// Anonymous memory without any page faulted in yet, so its pages land on the node of the
+// thread that writes them first
+inline void *alloc_untouched(size_t bytes) {
+    void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+inline void free_untouched(void *ptr, size_t bytes) {
+    if (ptr) munmap(ptr, bytes);
+}
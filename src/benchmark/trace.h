@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include "utils.h"
+
+// Binary workload trace: a TraceHeader followed by count fixed size TraceRecords, so a mapped
+// trace can be indexed and split across workers in place. Op codes are 0 read, 1 insert,
+// 2 delete, 3 scan, 4 update and 5 read-modify-write. arg is the length of a scan and the
+// payload of an insert or update, 0 stands for --scan_num and the default payload.
+struct TraceHeader {
+    char magic[8];
+    uint32_t key_size;
+    uint32_t record_size;
+    uint64_t count;
+};
+
+static constexpr char TRACE_MAGIC[8] = {'G', 'R', 'E', 'T', 'R', 'A', 'C', 'E'};
+
+template<class KEY_TYPE>
+struct TraceRecord {
+    KEY_TYPE key;
+    uint32_t arg;
+    uint8_t op;
+    uint8_t reserved[3];
+};
+
+// Write records under a temporary name and rename, like save_binary_data
+template<class KEY_TYPE>
+bool save_trace(const TraceRecord<KEY_TYPE> *records, size_t count, const std::string &file_path) {
+    static_assert(std::is_trivially_copyable<TraceRecord<KEY_TYPE>>::value, "records are written as bytes");
+    std::string tmp_path = file_path + ".tmp." + std::to_string(getpid());
+    std::ofstream os(tmp_path.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!os.is_open()) {
+        return false;
+    }
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.key_size = sizeof(KEY_TYPE);
+    header.record_size = sizeof(TraceRecord<KEY_TYPE>);
+    header.count = count;
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char *>(records), std::streamsize(count * sizeof(TraceRecord<KEY_TYPE>)));
+    os.close();
+    if (!os || rename(tmp_path.c_str(), file_path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Locate the records of a mapped trace. Returns their number, or -1 if the file is not a
+// complete trace of KEY_TYPE keys.
+template<class KEY_TYPE>
+long long map_trace(const MappedFile &file, const TraceRecord<KEY_TYPE> *&records) {
+    if (!file.is_open() || file.size < sizeof(TraceHeader)) {
+        return -1;
+    }
+    TraceHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.key_size != sizeof(KEY_TYPE) ||
+        header.record_size != sizeof(TraceRecord<KEY_TYPE>) ||
+        (file.size - sizeof(header)) / sizeof(TraceRecord<KEY_TYPE>) < header.count) {
+        return -1;
+    }
+    records = reinterpret_cast<const TraceRecord<KEY_TYPE> *>(file.data() + sizeof(header));
+    return header.count;
+}
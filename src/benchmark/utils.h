@@ -6,18 +6,24 @@
 #include <iostream>
 #include <functional>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <signal.h>
-#include "zipf.h"
+#include "string_key.h"
 #include "omp.h"
 #include <cassert>
+#include <cctype>
+#include <cmath>
 #include <chrono>
 #include <cstring>
 #include <fstream>
 #include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <random>
 #include <vector>
 #include "tbb/parallel_sort.h"
 
@@ -140,57 +146,313 @@ struct System {
     }
 };
 
+// Read-only private mapping of a whole file, unmapped when it goes out of scope.
+struct MappedFile {
+    void *addr = MAP_FAILED;
+    size_t size = 0;
+
+    explicit MappedFile(const std::string &file_path) {
+        int fd = open(file_path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = st.st_size;
+            addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                madvise(addr, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+                madvise(addr, size, MADV_HUGEPAGE);
+#endif
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (is_open()) munmap(addr, size);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool is_open() const { return addr != MAP_FAILED; }
+
+    const char *data() const { return static_cast<const char *>(addr); }
+};
+
+// Ask for transparent huge pages on the page-aligned interior of [ptr, ptr + bytes).
+// Must be called before the memory is first touched to have any effect.
+inline void advise_huge_pages(void *ptr, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    const uintptr_t page = 4096;
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + bytes) & ~(page - 1);
+    if (end > begin) madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+}
+
+// Locate the keys of a mapped SOSD-style binary file ([uint64 count][keys...]).
+// Returns the number of usable keys, clamped to length when length >= 0, 0 if the file
+// cannot be read and -1 if its size does not match count keys of sizeof(T) bytes.
+template<class T>
+long long map_binary_data(const MappedFile &file, const T *&data, long long length) {
+    if (!file.is_open() || file.size < sizeof(uint64_t)) {
+        return 0;
+    }
+    uint64_t count;
+    memcpy(&count, file.data(), sizeof(count));
+    if ((file.size - sizeof(count)) / sizeof(T) != count || (file.size - sizeof(count)) % sizeof(T) != 0) {
+        return -1;
+    }
+    if (length < 0 || length > (long long) count) length = count;
+    data = reinterpret_cast<const T *>(file.data() + sizeof(count));
+    return length;
+}
+
+template<class T>
+void parallel_copy(T *dst, const T *src, size_t n) {
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
+
+// Load string keys from a binary file of [uint64 count] followed by count records of
+// [uint16 length][bytes]. Returns -1 if the records do not end with the file.
+inline long long load_string_data(StringKey *&data, long long length, const std::string &file_path) {
+    MappedFile file(file_path);
+    if (!file.is_open() || file.size < sizeof(uint64_t)) {
+        return 0;
+    }
+    uint64_t count;
+    memcpy(&count, file.data(), sizeof(count));
+    // the records have no fixed stride, so find them all before copying in parallel
+    std::vector<size_t> offset(count + 1);
+    offset[0] = sizeof(count);
+    size_t truncated = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint16_t len;
+        if (offset[i] + sizeof(len) > file.size) return -1;
+        memcpy(&len, file.data() + offset[i], sizeof(len));
+        offset[i + 1] = offset[i] + sizeof(len) + len;
+        truncated += len > MAX_STRING_KEY_LEN;
+    }
+    if (offset[count] != file.size) {
+        return -1;
+    }
+    if (truncated > 0) {
+        std::cout << truncated << " keys are longer than " << MAX_STRING_KEY_LEN << " bytes and were truncated" << std::endl;
+    }
+    if (length < 0 || length > (long long) count) length = count;
+    data = new StringKey[length];
+#pragma omp parallel for schedule(static)
+    for (long long i = 0; i < length; i++) {
+        const char *record = file.data() + offset[i] + sizeof(uint16_t);
+        data[i] = StringKey(record, offset[i + 1] - offset[i] - sizeof(uint16_t));
+    }
+    return length;
+}
+
 template<class T>
 long long load_binary_data(T *&data, long long length, const std::string &file_path) {
-    // open key file
-    std::ifstream is(file_path.c_str(), std::ios::binary | std::ios::in);
-    if (!is.is_open()) {
+    if constexpr (std::is_same<T, StringKey>::value) {
+        return load_string_data(data, length, file_path);
+    }
+    // map key file
+    MappedFile file(file_path);
+    if (!file.is_open()) {
         return 0;
     }
 
     std::cout << file_path << std::endl;
 
-    // read the number of keys
-    T max_size;
-    is.read(reinterpret_cast<char*>(&max_size), sizeof(T));
-
-    std::cout << max_size << std::endl;
+    const T *file_keys;
+    length = map_binary_data(file, file_keys, length);
+    std::cout << length << std::endl;
+    if (length <= 0) {
+        return length;
+    }
 
-    // create array
-    if(length < 0 || length > max_size) length = max_size;
+    // create array, the copy below is its first touch
     data = new T[length];
-
-    // read keys
-    is.read(reinterpret_cast<char *>(data), std::streamsize(length * sizeof(T)));
-    is.close();
+    advise_huge_pages(data, length * sizeof(T));
+    parallel_copy(data, file_keys, length);
     return length;
 }
 
+// Write keys in the same [count][keys...] layout load_binary_data reads. The file is
+// written under a temporary name and renamed so a concurrent run never sees a partial file.
+template<class T>
+bool save_binary_data(const T *data, size_t length, const std::string &file_path) {
+    std::string tmp_path = file_path + ".tmp." + std::to_string(getpid());
+    std::ofstream os(tmp_path.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!os.is_open()) {
+        return false;
+    }
+    uint64_t count = length;
+    os.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    os.write(reinterpret_cast<const char *>(data), std::streamsize(length * sizeof(T)));
+    os.close();
+    if (!os || rename(tmp_path.c_str(), file_path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// A derived file is usable if it exists and is not older than the file it was built from.
+inline bool is_fresh_cache(const std::string &cache_path, const std::string &source_path) {
+    struct stat cache_st, source_st;
+    if (stat(cache_path.c_str(), &cache_st) != 0 || stat(source_path.c_str(), &source_st) != 0) {
+        return false;
+    }
+    return cache_st.st_mtime >= source_st.st_mtime;
+}
+
+// Copy the distinct values of a sorted array to out (which must not overlap it).
+// Returns the number of distinct values.
+template<class T>
+size_t parallel_unique(const T *sorted, size_t n, T *out) {
+    const size_t chunks = omp_get_max_threads();
+    std::vector<size_t> offset(chunks + 1, 0);
+#pragma omp parallel for schedule(static, 1)
+    for (size_t c = 0; c < chunks; c++) {
+        size_t cnt = 0;
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+            cnt += (i == 0 || sorted[i] != sorted[i - 1]);
+        }
+        offset[c + 1] = cnt;
+    }
+    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+#pragma omp parallel for schedule(static, 1)
+    for (size_t c = 0; c < chunks; c++) {
+        size_t pos = offset[c];
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+            if (i == 0 || sorted[i] != sorted[i - 1]) out[pos++] = sorted[i];
+        }
+    }
+    return offset[chunks];
+}
+
+// Write a uniformly random permutation of in to out (which must not overlap it).
+// Each input chunk scatters its elements into random buckets, then every bucket is
+// shuffled locally. The chunk and bucket counts are fixed, so the permutation only
+// depends on the seed and not on the number of threads.
+template<class T>
+void parallel_shuffle(const T *in, size_t n, T *out, size_t seed) {
+    const size_t chunks = 256, buckets = 256;
+    std::vector<size_t> offset(chunks * buckets, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < chunks; c++) {
+        std::mt19937_64 gen(seed + c);
+        std::uniform_int_distribution<size_t> dis(0, buckets - 1);
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+            offset[c * buckets + dis(gen)]++;
+        }
+    }
+    // bucket-major exclusive prefix sum, so each bucket is contiguous in out
+    std::vector<size_t> bucket_begin(buckets + 1, 0);
+    size_t sum = 0;
+    for (size_t b = 0; b < buckets; b++) {
+        bucket_begin[b] = sum;
+        for (size_t c = 0; c < chunks; c++) {
+            size_t cnt = offset[c * buckets + b];
+            offset[c * buckets + b] = sum;
+            sum += cnt;
+        }
+    }
+    bucket_begin[buckets] = sum;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < chunks; c++) {
+        std::mt19937_64 gen(seed + c);
+        std::uniform_int_distribution<size_t> dis(0, buckets - 1);
+        size_t *pos = &offset[c * buckets];
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+            out[pos[dis(gen)]++] = in[i];
+        }
+    }
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t b = 0; b < buckets; b++) {
+        std::mt19937_64 gen(seed ^ (0x9E3779B97F4A7C15ull * (b + 1)));
+        std::shuffle(out + bucket_begin[b], out + bucket_begin[b + 1], gen);
+    }
+}
+
+// Parse one decimal key starting at p. Integer keys use a hand-rolled parser, string keys
+// take the line as it is and other key types fall back to strtod.
+template<class T>
+inline T parse_text_key(const char *p, const char *end) {
+    if constexpr (std::is_same<T, StringKey>::value) {
+        return StringKey(p, end - p);
+    } else if constexpr (std::is_integral<T>::value) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+        T key = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            key = key * 10 + (*p++ - '0');
+        }
+        return negative ? static_cast<T>(0 - key) : key;
+    } else {
+        std::string token(p, end);
+        return static_cast<T>(strtod(token.c_str(), nullptr));
+    }
+}
+
+// Call fn(begin, end) for every non-blank line in [begin, end), with surrounding blanks trimmed.
+template<class F>
+inline void for_each_text_line(const char *begin, const char *end, F &&fn) {
+    while (begin < end) {
+        const char *eol = static_cast<const char *>(memchr(begin, '\n', end - begin));
+        if (eol == nullptr) eol = end;
+        const char *b = begin, *e = eol;
+        while (b < e && isspace(static_cast<unsigned char>(*b))) b++;
+        while (e > b && isspace(static_cast<unsigned char>(e[-1]))) e--;
+        if (b < e) fn(b, e);
+        begin = eol + 1;
+    }
+}
+
+// Load one key per line. The file is split into newline-aligned byte ranges that are
+// counted and then parsed in parallel, straight into an array of the final size.
 template<class T>
 long long load_text_data(T *&array, long long length, const std::string &file_path) {
-    std::ifstream is(file_path.c_str());
-    if (!is.is_open()) {
+    MappedFile file(file_path);
+    if (!file.is_open()) {
         return 0;
     }
-    long long i = 0;
-    std::string str;
-
-    std::vector<T> temp_keys;
-    temp_keys.reserve(200000000);
-    while (std::getline(is, str) && (i < length || length < 0)) {
-        std::istringstream ss(str);
-        T key;
-        ss >> key;
-        temp_keys.push_back(key);
-        i++;
+    const char *text = file.data();
+    const size_t chunks = omp_get_max_threads() * 4;
+
+    std::vector<const char *> bound(chunks + 1);
+    bound[0] = text;
+    bound[chunks] = text + file.size;
+    for (size_t c = 1; c < chunks; c++) {
+        const char *p = std::max(text + file.size * c / chunks, bound[c - 1]);
+        const char *eol = static_cast<const char *>(memchr(p, '\n', text + file.size - p));
+        bound[c] = eol ? eol + 1 : text + file.size;
     }
 
-    array = new T[temp_keys.size()];
-    for(int j = 0; j < temp_keys.size(); j++) {
-        array[j] = temp_keys[j];
+    std::vector<long long> offset(chunks + 1, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < chunks; c++) {
+        long long cnt = 0;
+        for_each_text_line(bound[c], bound[c + 1], [&](const char *, const char *) { cnt++; });
+        offset[c + 1] = cnt;
     }
-    is.close();
-    return temp_keys.size();
+    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+    if (length < 0 || length > offset[chunks]) length = offset[chunks];
+
+    array = new T[length];
+    advise_huge_pages(array, length * sizeof(T));
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < chunks; c++) {
+        if (offset[c] >= length) continue;
+        long long pos = offset[c];
+        for_each_text_line(bound[c], bound[c + 1], [&](const char *b, const char *e) {
+            if (pos < length) array[pos++] = parse_text_key<T>(b, e);
+        });
+    }
+    return length;
 }
 
 template<class T>
@@ -215,22 +477,56 @@ T *get_search_keys(T array[], int num_keys, int num_searches, size_t *seed = nul
 }
 
 
-bool file_exists(const std::string &str) {
-    std::ifstream fs(str);
-    return fs.is_open();
+// Read a memory field of /proc/self/status such as "VmRSS" or "VmHWM", in bytes
+inline long long get_proc_memory(const std::string &field) {
+    std::ifstream is("/proc/self/status");
+    std::string line;
+    while (std::getline(is, line)) {
+        if (line.compare(0, field.size() + 1, field + ":") == 0) {
+            return std::stoll(line.substr(field.size() + 1)) * 1024;
+        }
+    }
+    return 0;
 }
 
-template<class T>
-T *get_search_keys_zipf(T array[], int num_keys, int num_searches, size_t *seed = nullptr) {
-    auto *keys = new T[num_searches];
-    ScrambledZipfianGenerator zipf_gen(num_keys, seed);
-    for (int i = 0; i < num_searches; i++) {
-        int pos = zipf_gen.nextValue();
-        keys[i] = array[pos];
-    }
-    return keys;
+// Reset the peak resident set size (VmHWM) to the current one. Returns false on kernels
+// without support, where VmHWM keeps the peak of the whole process lifetime.
+inline bool reset_peak_rss() {
+    std::ofstream os("/proc/self/clear_refs");
+    os << "5";
+    os.close();
+    return os.good();
 }
 
+// splitmix64, cheap enough to not show up next to an index operation
+inline uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Mean, sample standard deviation and half width of the 95% confidence interval of the mean
+// (Student's t) of a set of measurements
+inline void mean_confidence(const std::vector<double> &x, double &mean, double &stddev, double &ci95) {
+    static const double t_975[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    mean = stddev = ci95 = 0;
+    if (x.empty()) return;
+    mean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+    if (x.size() < 2) return;
+    double square = 0;
+    for (auto v : x) square += (v - mean) * (v - mean);
+    stddev = std::sqrt(square / (x.size() - 1));
+    size_t df = x.size() - 1;
+    ci95 = (df <= 30 ? t_975[df - 1] : 1.96) * stddev / std::sqrt((double) x.size());
+}
+
+bool file_exists(const std::string &str) {
+    std::ifstream fs(str);
+    return fs.is_open();
+}
 
 template<typename T>
 T *unique_data(T *key1, size_t &size1, T *key2, size_t &size2) {
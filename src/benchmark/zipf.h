@@ -1,75 +1,79 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT license.
-#include <iomanip>
-#include <fstream>
-#include <iostream>
-#include <stack>
-#include <type_traits>
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <random>
+#include <vector>
 // Zipf generator, inspired by
 // https://github.com/brianfrankcooper/YCSB/blob/master/core/src/main/java/site/ycsb/generator/ScrambledZipfianGenerator.java
 // https://github.com/brianfrankcooper/YCSB/blob/master/core/src/main/java/site/ycsb/generator/ZipfianGenerator.java
 
-class ScrambledZipfianGenerator {
- public:
-  static constexpr double ZETAN = 26.46902820178302;
-  static constexpr double ZIPFIAN_CONSTANT = 0.99;
+// zeta(n, theta) = sum of 1 / i^theta for i = 1..n. The terms are summed in parallel in
+// fixed blocks, so the result does not depend on the number of threads.
+inline double zeta(size_t n, double theta) {
+  const size_t block = 1 << 16;
+  std::vector<double> partial((n + block - 1) / block, 0.0);
+#pragma omp parallel for schedule(static)
+  for (size_t b = 0; b < partial.size(); b++) {
+    double sum = 0.0;
+    for (size_t i = b * block + 1; i <= std::min(n, (b + 1) * block); i++) {
+      sum += 1 / std::pow((double)i, theta);
+    }
+    partial[b] = sum;
+  }
+  double sum = 0.0;
+  for (double p : partial) sum += p;
+  return sum;
+}
 
-  int num_keys_;
+// Ranks 0..num_keys-1, rank 0 the most popular, with P(rank) proportional to 1 / (rank+1)^theta
+// for 0 < theta < 1. zetan is zeta(num_keys, theta), which generators of the same key count
+// share since it is the expensive part.
+class ZipfianGenerator {
+ public:
+  size_t num_keys_;
+  double theta_;
+  double zetan_;
   double alpha_;
   double eta_;
   std::mt19937_64 gen_;
   std::uniform_real_distribution<double> dis_;
 
-  explicit ScrambledZipfianGenerator(int num_keys, size_t *seed)
-      : num_keys_(num_keys), gen_(std::random_device{}()), dis_(0, 1) {
-    if(seed) {
-      gen_.seed(*seed);
-    }
-    double zeta2theta = zeta(2);
-    alpha_ = 1. / (1. - ZIPFIAN_CONSTANT);
-    eta_ = (1 - std::pow(2. / num_keys_, 1 - ZIPFIAN_CONSTANT)) /
-           (1 - zeta2theta / ZETAN);
+  ZipfianGenerator(size_t num_keys, double theta, double zetan, uint64_t seed)
+      : num_keys_(num_keys), theta_(theta), zetan_(zetan), gen_(seed), dis_(0, 1) {
+    double zeta2theta = 1 + std::pow(0.5, theta_);
+    alpha_ = 1. / (1. - theta_);
+    eta_ = (1 - std::pow(2. / num_keys_, 1 - theta_)) / (1 - zeta2theta / zetan_);
   }
 
-  int nextValue() {
+  size_t nextValue() {
     double u = dis_(gen_);
-    double uz = u * ZETAN;
-
-    int ret;
-    if (uz < 1.0) {
-      ret = 0;
-    } else if (uz < 1.0 + std::pow(0.5, ZIPFIAN_CONSTANT)) {
-      ret = 1;
-    } else {
-      ret = (int)(num_keys_ * std::pow(eta_ * u - eta_ + 1, alpha_));
-    }
+    double uz = u * zetan_;
 
-    ret = fnv1a(ret) % num_keys_;
-    return ret;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return std::min<size_t>(1, num_keys_ - 1);
+    auto ret = (size_t)(num_keys_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+    return std::min(ret, num_keys_ - 1);
   }
+};
 
-  double zeta(long n) {
-    double sum = 0.0;
-    for (long i = 0; i < n; i++) {
-      sum += 1 / std::pow(i + 1, ZIPFIAN_CONSTANT);
-    }
-    return sum;
-  }
+// Zipfian ranks hashed over the key positions, so the popular keys are spread over the key
+// space instead of being the smallest ones
+class ScrambledZipfianGenerator : public ZipfianGenerator {
+ public:
+  using ZipfianGenerator::ZipfianGenerator;
 
-  // FNV hash from https://create.stephan-brumme.com/fnv-hash/
-  static const uint32_t PRIME = 0x01000193;  //   16777619
-  static const uint32_t SEED = 0x811C9DC5;   // 2166136261
-  /// hash a single byte
-  inline uint32_t fnv1a(unsigned char oneByte, uint32_t hash = SEED) {
-    return (oneByte ^ hash) * PRIME;
-  }
-  /// hash a 32 bit integer (four bytes)
-  inline uint32_t fnv1a(int fourBytes, uint32_t hash = SEED) {
-    const unsigned char* ptr = (const unsigned char*)&fourBytes;
-    hash = fnv1a(*ptr++, hash);
-    hash = fnv1a(*ptr++, hash);
-    hash = fnv1a(*ptr++, hash);
-    return fnv1a(*ptr, hash);
+  size_t nextValue() { return fnv1a(ZipfianGenerator::nextValue()) % num_keys_; }
+
+  // 64-bit FNV-1a of the 8 bytes of a rank, as YCSB's fnvhash64
+  static uint64_t fnv1a(uint64_t value) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int i = 0; i < 8; i++) {
+      hash = (hash ^ (value & 0xff)) * 0x100000001B3ull;
+      value >>= 8;
+    }
+    return hash;
   }
-};
\ No newline at end of file
+};
@@ -2,7 +2,7 @@
 #include"../indexInterface.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class alexInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class alexInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   void init(Param *param = nullptr) {}
 
@@ -49,8 +49,12 @@ bool alexInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool alexInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-    // return index.update(key, value);
-    return false;
+  PAYLOAD_TYPE *res = index.get_payload(key);
+  if (res != nullptr) {
+    *res = value;
+    return true;
+  }
+  return false;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
@@ -1,10 +1,11 @@
+#include <algorithm>
 #include"./src/alex.h"
 #include"../indexInterface.h"
 
 int counter = 0;
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class alexolInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class alexolInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
     void init(Param *param = nullptr) {}
 
@@ -12,6 +13,11 @@ public:
 
     bool get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param = nullptr);
 
+    size_t multi_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found, Param *param = nullptr);
+
+    size_t interleaved_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found, size_t group,
+                           Param *param = nullptr);
+
     bool put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
 
     bool update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
@@ -47,6 +53,24 @@ bool alexolInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &va
     return ret;
 }
 
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+size_t alexolInterface<KEY_TYPE, PAYLOAD_TYPE>::multi_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals,
+                                                          bool *found, Param *param) {
+    index.get_payload_batch(keys, (int) num, vals, found);
+    return std::count(found, found + num, true);
+}
+
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+size_t alexolInterface<KEY_TYPE, PAYLOAD_TYPE>::interleaved_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals,
+                                                                bool *found, size_t group, Param *param) {
+    typedef typename decltype(index)::LookupTask task_t;
+    typename decltype(index)::EpochGuard guard;
+    run_interleaved<task_t>(num, group, [&](task_t &task, size_t i) {
+        return index.get_payload_step(task, keys[i], &vals[i], &found[i]);
+    });
+    return std::count(found, found + num, true);
+}
+
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool alexolInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
     return index.insert(key, value);
@@ -625,39 +625,47 @@ public:
       cur = node->children_[bucketID];
 
       if (cur->is_leaf_) {
-        auto leaf = static_cast<data_node_type *>(cur);
-        // Doesn't really matter if rounding is incorrect, we just want it to be
-        // fast.
-        // So we don't need to use std::round or std::lround.
-        int bucketID_prediction_rounded =
-            static_cast<int>(bucketID_prediction + 0.5);
-        double tolerance =
-            10 * std::numeric_limits<double>::epsilon() * bucketID_prediction;
-        // https://stackoverflow.com/questions/17333/what-is-the-most-effective-way-for-float-and-double-comparison
-        if (std::abs(bucketID_prediction - bucketID_prediction_rounded) <=
-            tolerance) {
-          if (bucketID_prediction_rounded <= bucketID_prediction) {
-            // To be safe, need to snapshot the prev_leaf_
-            auto prev_leaf = leaf->prev_leaf_;
-            if (prev_leaf && prev_leaf->max_limit_ > key) {
-              if (leaf->prev_leaf_ != prev_leaf) {
-                return nullptr;
-              }
-              return prev_leaf;
-            }
-          } else {
-            auto next_leaf = leaf->next_leaf_;
-            if (next_leaf && next_leaf->min_limit_ <= key) {
-              if (leaf->next_leaf_ != next_leaf) {
-                return nullptr;
-              }
-              return next_leaf;
-            }
+        return adjust_leaf(static_cast<data_node_type *>(cur),
+                           bucketID_prediction, key);
+      }
+    }
+  }
+
+  // A key predicted right on a bucket boundary may belong to the neighbouring
+  // leaf. Returns nullptr if the neighbour changed while we looked at it.
+  forceinline data_node_type *adjust_leaf(data_node_type *leaf,
+                                          double bucketID_prediction,
+                                          T key) const {
+    // Doesn't really matter if rounding is incorrect, we just want it to be
+    // fast.
+    // So we don't need to use std::round or std::lround.
+    int bucketID_prediction_rounded =
+        static_cast<int>(bucketID_prediction + 0.5);
+    double tolerance =
+        10 * std::numeric_limits<double>::epsilon() * bucketID_prediction;
+    // https://stackoverflow.com/questions/17333/what-is-the-most-effective-way-for-float-and-double-comparison
+    if (std::abs(bucketID_prediction - bucketID_prediction_rounded) <=
+        tolerance) {
+      if (bucketID_prediction_rounded <= bucketID_prediction) {
+        // To be safe, need to snapshot the prev_leaf_
+        auto prev_leaf = leaf->prev_leaf_;
+        if (prev_leaf && prev_leaf->max_limit_ > key) {
+          if (leaf->prev_leaf_ != prev_leaf) {
+            return nullptr;
           }
+          return prev_leaf;
+        }
+      } else {
+        auto next_leaf = leaf->next_leaf_;
+        if (next_leaf && next_leaf->min_limit_ <= key) {
+          if (leaf->next_leaf_ != next_leaf) {
+            return nullptr;
+          }
+          return next_leaf;
         }
-        return leaf;
       }
     }
+    return leaf;
   }
 #else
   data_node_type *
@@ -1334,6 +1342,131 @@ public:
     } while (true);
   }
 
+  // Batched get_payload that descends level by level across the batch: every
+  // round moves each lookup one level down and prefetches the node it reaches, so
+  // the misses of one level of all the lookups overlap. The predicted slots of the
+  // data nodes are prefetched before the last-mile searches.
+  void get_payload_batch(const T *keys, int num, P *payloads, bool *found) const {
+    EpochGuard guard;
+    constexpr int batch = 32;
+    AlexNode<T, P> *nodes[batch];
+    double predictions[batch];
+    for (int begin = 0; begin < num; begin += batch) {
+      int n = std::min(batch, num - begin);
+      // one read of the root per batch: a concurrent root split must not change whether the
+      // descent below ran, or adjust_leaf would read predictions it never made
+      AlexNode<T, P> *root = root_node_;
+      for (int i = 0; i < n; i++) {
+        nodes[i] = root;
+      }
+      for (bool descending = !root->is_leaf_; descending;) {
+        descending = false;
+        for (int i = 0; i < n; i++) {
+          if (nodes[i]->is_leaf_) continue;
+          auto node = static_cast<model_node_type *>(nodes[i]);
+          predictions[i] = node->model_.predict_double(keys[begin + i]);
+          int bucketID = std::min<int>(
+              std::max<int>(static_cast<int>(predictions[i]), 0),
+              node->num_children_ - 1);
+          nodes[i] = node->children_[bucketID];
+          __builtin_prefetch(nodes[i]);
+          descending = true;
+        }
+      }
+      for (int i = 0; i < n; i++) {
+        auto leaf = static_cast<data_node_type *>(nodes[i]);
+#if ALEX_SAFE_LOOKUP
+        if (!root->is_leaf_) {
+          leaf = adjust_leaf(leaf, predictions[i], keys[begin + i]);
+          nodes[i] = leaf;
+          if (!leaf) continue;
+        }
+#endif
+        int pos = leaf->predict_position(keys[begin + i]);
+#if ALEX_DATA_NODE_SEP_ARRAYS
+        __builtin_prefetch(&leaf->key_slots_[pos]);
+        __builtin_prefetch(&leaf->payload_slots_[pos]);
+#else
+        __builtin_prefetch(&leaf->data_slots_[pos]);
+#endif
+      }
+      for (int i = 0; i < n; i++) {
+        const T &key = keys[begin + i];
+        auto leaf = static_cast<data_node_type *>(nodes[i]);
+        // same retry as get_payload when a concurrent writer got in the way
+        while (!leaf || !leaf->find_payload(key, &payloads[begin + i], &found[begin + i])) {
+          leaf = get_leaf(key);
+        }
+      }
+    }
+  }
+
+  // State of a resumable get_payload, see get_payload_step
+  struct LookupTask {
+    int stage = 0;
+    model_node_type *node = nullptr;
+    int bucketID = 0;
+    double bucketID_prediction = 0;
+    AlexNode<T, P> *child = nullptr;
+    data_node_type *leaf = nullptr;
+  };
+
+  // get_payload split at its cache misses (child pointer, child node, data
+  // slot) for interleaved execution. Each call prefetches what the next one
+  // reads and returns false, or returns true once payload and found are set.
+  // The caller holds an EpochGuard across all steps of the lookup.
+  bool get_payload_step(LookupTask &task, const T &key, P *payload,
+                        bool *found) const {
+    switch (task.stage) {
+    case 0:
+      task.child = root_node_;
+      break;
+    case 1:
+      task.child = task.node->children_[task.bucketID];
+      __builtin_prefetch(task.child);
+      task.stage = 2;
+      return false;
+    case 2:
+      break;
+    default:
+      if (task.leaf->find_payload(key, payload, found)) {
+        return true;
+      }
+      task.stage = 0; // a concurrent writer got in the way, start over
+      return false;
+    }
+    // visit the child
+    if (!task.child->is_leaf_) {
+      task.node = static_cast<model_node_type *>(task.child);
+      task.bucketID_prediction = task.node->model_.predict_double(key);
+      task.bucketID = std::min<int>(
+          std::max<int>(static_cast<int>(task.bucketID_prediction), 0),
+          task.node->num_children_ - 1);
+      __builtin_prefetch(&task.node->children_[task.bucketID]);
+      task.stage = 1;
+      return false;
+    }
+    task.leaf = static_cast<data_node_type *>(task.child);
+#if ALEX_SAFE_LOOKUP
+    if (task.node) {
+      task.leaf = adjust_leaf(task.leaf, task.bucketID_prediction, key);
+      if (!task.leaf) {
+        task = LookupTask();
+        return false;
+      }
+    }
+#endif
+    int pos = task.leaf->predict_position(key);
+#if ALEX_DATA_NODE_SEP_ARRAYS
+    __builtin_prefetch(&task.leaf->key_slots_[pos]);
+    __builtin_prefetch(&task.leaf->payload_slots_[pos]);
+#else
+    __builtin_prefetch(&task.leaf->data_slots_[pos]);
+#endif
+    task.stage = 3;
+    return false;
+  }
+
   bool update(const T &key, const P &payload) const {
     EpochGuard guard;
     do {
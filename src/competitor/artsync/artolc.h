@@ -2,20 +2,32 @@
 #include"./src/OptimisticLockCoupling/Tree.cpp"
 #include"../indexInterface.h"
 #include "tbb/tbb.h"
+#include <optional>
 #include <utility>
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class ARTOLCInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class ARTOLCInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
 
     ARTOLCInterface() {
         idx = new ART_OLC::Tree(loadKey);
-        auto temp= new std::pair<KEY_TYPE,PAYLOAD_TYPE>(~0ull,0);
-        loadKey(reinterpret_cast<uint64_t>(&temp), maxKey);
+        auto temp= new std::pair<KEY_TYPE,PAYLOAD_TYPE>(max_key<KEY_TYPE>(),0);
+        loadKey(reinterpret_cast<TID>(temp), maxKey);
     }
 
     void init(Param *param = nullptr) {}
 
+    // Every thread keeps the epoch ThreadInfo of this tree from register_thread on, it has to be
+    // made on the thread that uses it
+    void register_thread(Param *param) {
+        param->context = new ThreadInfo(idx->getThreadInfo());
+    }
+
+    void unregister_thread(Param *param) {
+        delete static_cast<ThreadInfo *>(param->context);
+        param->context = nullptr;
+    }
+
     void bulk_load(std::pair <KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num, Param *param = nullptr);
 
     bool get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param = nullptr);
@@ -28,10 +40,10 @@ public:
 
     size_t scan(KEY_TYPE key_low_bound, size_t key_num, std::pair <KEY_TYPE, PAYLOAD_TYPE> *result,
                 Param *param = nullptr) {
-        thread_local static auto t = idx->getThreadInfo();
+        ThreadInfoRef t(idx, param);
         Key k;
-        k.setKeyLen(sizeof(key_low_bound));
-        reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key_low_bound);
+        KeyBytes<KEY_TYPE> bytes(key_low_bound);
+        k.set(bytes.data(), bytes.size());
 
         TID results[key_num];
         size_t resultCount;
@@ -49,8 +61,8 @@ public:
         // Implementation is database specific
 
         std::pair<KEY_TYPE, PAYLOAD_TYPE> * valPtr = reinterpret_cast<std::pair<KEY_TYPE, PAYLOAD_TYPE> *>(tid);
-        KEY_TYPE reversed = swap_endian(valPtr->first);
-        key.set(reinterpret_cast<char *>(&reversed), sizeof(valPtr->first));
+        KeyBytes<KEY_TYPE> bytes(valPtr->first);
+        key.set(bytes.data(), bytes.size());
         // key.setKeyLen(sizeof(valPtr->first));
         // reinterpret_cast<KEY_TYPE *>(&key[0])[0] = swap_endian(valPtr->first);
     }
@@ -60,14 +72,25 @@ public:
     }
 
 private:
+    // The ThreadInfo the calling thread registered, or one for a single operation
+    struct ThreadInfoRef {
+        ThreadInfoRef(ART_OLC::Tree *idx, Param *param) {
+            if (param && param->context) {
+                info = static_cast<ThreadInfo *>(param->context);
+            } else {
+                local.emplace(idx->getThreadInfo());
+                info = &*local;
+            }
+        }
+
+        operator ThreadInfo &() { return *info; }
+
+        ThreadInfo *info;
+        std::optional<ThreadInfo> local;
+    };
+
     Key maxKey;
     ART_OLC::Tree *idx;
-    inline static uint32_t swap_endian(uint32_t i) {
-        return __builtin_bswap32(i);
-    }
-    inline static uint64_t swap_endian(uint64_t i) {
-        return __builtin_bswap64(i);
-    }
 };
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
@@ -80,12 +103,12 @@ void ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYPE, PAY
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
-    thread_local static auto t = idx->getThreadInfo();
+    ThreadInfoRef t(idx, param);
     Key k;
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     auto valPtr = reinterpret_cast<std::pair<KEY_TYPE, PAYLOAD_TYPE>*>(idx->lookup(k,t));
     if(valPtr) {
         val = valPtr->second;
@@ -97,39 +120,39 @@ bool ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &va
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-    thread_local static auto t = idx->getThreadInfo();
+    ThreadInfoRef t(idx, param);
 
     auto temp = new std::pair<KEY_TYPE, PAYLOAD_TYPE>(key,value);
     Key k;
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     idx->insert(k, reinterpret_cast<TID>(temp),t);
     return true;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-    thread_local static auto t = idx->getThreadInfo();
+    ThreadInfoRef t(idx, param);
     auto temp = new std::pair<KEY_TYPE, PAYLOAD_TYPE>(key,value);
     Key k;
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     return idx->update(k, reinterpret_cast<TID>(temp), t);
 }
 
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
-    thread_local static auto t = idx->getThreadInfo();
+    ThreadInfoRef t(idx, param);
     Key k;
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     idx->remove(k, t);
     return true;
 }
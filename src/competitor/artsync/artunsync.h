@@ -6,13 +6,13 @@
 #include "tbb/enumerable_thread_specific.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class ARTUnsynchronizedInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class ARTUnsynchronizedInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
 
     ARTUnsynchronizedInterface() {
         idx = new ART_unsynchronized::Tree(loadKey);
-        auto temp= new std::pair<KEY_TYPE,PAYLOAD_TYPE>(~0ull,0);
-        loadKey(reinterpret_cast<uint64_t>(&temp), maxKey);
+        auto temp= new std::pair<KEY_TYPE,PAYLOAD_TYPE>(max_key<KEY_TYPE>(),0);
+        loadKey(reinterpret_cast<TID>(temp), maxKey);
     }
 
     void init(Param *param = nullptr) {}
@@ -48,8 +48,8 @@ public:
         // Implementation is database specific
 
         std::pair<KEY_TYPE, PAYLOAD_TYPE> * valPtr = reinterpret_cast<std::pair<KEY_TYPE, PAYLOAD_TYPE> *>(tid);
-        KEY_TYPE reversed = swap_endian(valPtr->first);
-        key.set(reinterpret_cast<char *>(&reversed), sizeof(valPtr->first));
+        KeyBytes<KEY_TYPE> bytes(valPtr->first);
+        key.set(bytes.data(), bytes.size());
         // key.setKeyLen(sizeof(valPtr->first));
         // reinterpret_cast<KEY_TYPE *>(&key[0])[0] = swap_endian(valPtr->first);
     }
@@ -61,12 +61,6 @@ public:
 private:
     Key maxKey;
     ART_unsynchronized::Tree *idx;
-    inline static uint32_t swap_endian(uint32_t i) {
-        return __builtin_bswap32(i);
-    }
-    inline static uint64_t swap_endian(uint64_t i) {
-        return __builtin_bswap64(i);
-    }
 };
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
@@ -81,10 +75,10 @@ ARTUnsynchronizedInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYP
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTUnsynchronizedInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
     Key k;
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     auto valPtr = reinterpret_cast<std::pair<KEY_TYPE, PAYLOAD_TYPE>*>(idx->lookup(k));
     if(valPtr) {
         val = valPtr->second;
@@ -98,10 +92,10 @@ template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTUnsynchronizedInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
     Key k;
     auto temp = new std::pair<KEY_TYPE, PAYLOAD_TYPE>(key,value);
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     idx->insert(k, reinterpret_cast<TID>(temp));
     return true;
 }
@@ -110,20 +104,20 @@ template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTUnsynchronizedInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
     Key k;
     auto temp = new std::pair<KEY_TYPE, PAYLOAD_TYPE>(key,value);
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     return idx->update(k, reinterpret_cast<TID>(temp));
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool ARTUnsynchronizedInterface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
     Key k;
-    KEY_TYPE reversed = swap_endian(key);
+    KeyBytes<KEY_TYPE> bytes(key);
     // k.setKeyLen(sizeof(key));
     // reinterpret_cast<KEY_TYPE *>(&k[0])[0] = swap_endian(key);
-    k.set(reinterpret_cast<char *>(&reversed), sizeof(key));
+    k.set(bytes.data(), bytes.size());
     idx->remove(k);
     return true;
 }
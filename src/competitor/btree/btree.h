@@ -2,7 +2,7 @@
 #include"../indexInterface.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class BTreeInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class BTreeInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   void init(Param *param = nullptr) {}
 
@@ -19,24 +19,12 @@ public:
   size_t scan(KEY_TYPE key_low_bound, size_t key_num, std::pair<KEY_TYPE, PAYLOAD_TYPE> *result,
               Param *param = nullptr) {
     auto iter = idx.lower_bound(key_low_bound);
-
-    if (iter == idx.end()) {
-      return 0;
-    }
-
-    uint64_t sum = 0;
-    sum++;
-    PAYLOAD_TYPE accumulator = 0;
-    for (size_t i = 0; i < key_num; i++) {
+    size_t scan_size;
+    for (scan_size = 0; scan_size < key_num && iter != idx.end(); scan_size++) {
+      result[scan_size] = {iter->first, iter->second};
       ++iter;
-      sum++;
-      if (iter == idx.end()) {
-        break;
-      }
-      accumulator += iter->second;
     }
-    return sum;
-
+    return scan_size;
   }
 
   long long memory_consumption() { return 0; }
@@ -70,7 +58,13 @@ bool BTreeInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE valu
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool BTreeInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
+  auto iter = idx.find(key);
+  if (iter != idx.end()) {
+    iter.data() = value;
+    return true;
+  } else {
     return false;
+  }
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
@@ -2,7 +2,7 @@
 #include"../indexInterface.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class BTreeOLCInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class BTreeOLCInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   void init(Param *param = nullptr) {}
 
@@ -23,6 +23,9 @@ public:
 
   long long memory_consumption() { return 0; }
 
+  // BTreeOLC has no remove
+  bool supports_remove() { return false; }
+
 private:
   btreeolc::BTree<KEY_TYPE, PAYLOAD_TYPE> idx;
 };
@@ -49,7 +52,11 @@ bool BTreeOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE v
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool BTreeOLCInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-    return false;
+  // insert overwrites the payload of a key the tree holds, and no key ever leaves the tree
+  PAYLOAD_TYPE old;
+  if (!idx.lookup(key, old)) return false;
+  idx.insert(key, value);
+  return true;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
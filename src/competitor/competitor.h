@@ -12,65 +12,102 @@
 #include "./lippol/lippol.h"
 #include "pgm/pgm.h"
 #include "btree/btree.h"
-// #include "wormhole/wormhole.h"
+#include "wormhole/wormhole.h"
 #include "wormhole_u64/wormhole_u64.h"
 #include "masstree/masstree.h"
 #include "finedex/finedex.h"
 #include "iostream"
+#include <type_traits>
+
+// Learned indexes and BTreeOLC compute on keys as numbers
+template<class KEY_TYPE>
+constexpr bool numeric_key = std::is_arithmetic<KEY_TYPE>::value;
+
+// ART, HOT, Masstree and Wormhole compare keys as byte strings, which orders unsigned integers
+// (big-endian) and string keys
+template<class KEY_TYPE>
+constexpr bool byte_ordered_key = (std::is_integral<KEY_TYPE>::value && std::is_unsigned<KEY_TYPE>::value) ||
+                                  std::is_same<KEY_TYPE, StringKey>::value;
+
+// wormhole_u64 stores the payload in place of a value pointer, Wormhole stores it as an 8-byte value
+template<class PAYLOAD_TYPE>
+constexpr bool word_payload = std::is_same<PAYLOAD_TYPE, uint64_t>::value;
+
+[[noreturn]] inline void unsupported_key_type(const std::string &index_type) {
+  std::cout << index_type << " does not support this --key_type or --payload_size, see the README.\n";
+  exit(0);
+}
+
+// The adapters are only instantiated for the key types they support
+template<template<class, class> class INDEX, bool SUPPORTED, class KEY_TYPE, class PAYLOAD_TYPE>
+void make_index(indexInterface<KEY_TYPE, PAYLOAD_TYPE> *&index, const std::string &index_type) {
+  if constexpr (SUPPORTED) {
+    index = new INDEX<KEY_TYPE, PAYLOAD_TYPE>;
+  } else {
+    unsupported_key_type(index_type);
+  }
+}
+
+template<template<class, class> class INDEX, bool SUPPORTED, class KEY_TYPE, class PAYLOAD_TYPE, class F>
+void cast_index(indexInterface<KEY_TYPE, PAYLOAD_TYPE> *index, F &f) {
+  if constexpr (SUPPORTED) {
+    f(static_cast<INDEX<KEY_TYPE, PAYLOAD_TYPE> *>(index));
+  }
+}
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 indexInterface<KEY_TYPE, PAYLOAD_TYPE> *get_index(std::string index_type) {
   indexInterface<KEY_TYPE, PAYLOAD_TYPE> *index;
   if (index_type == "alexol") {
-    index = new alexolInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<alexolInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else if(index_type == "alex") {
-    index = new alexInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<alexInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "btreeolc") {
-    index = new BTreeOLCInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<BTreeOLCInterface, numeric_key<KEY_TYPE>>(index, index_type);
+  }
+  else if (index_type == "wormhole") {
+    make_index<WormholeInterface, byte_ordered_key<KEY_TYPE> && word_payload<PAYLOAD_TYPE>>(index, index_type);
   }
-  // else if (index_type == "wormhole") {
-  //   index = new WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>;
-  // }
   else if (index_type == "wormhole_u64") {
-    index = new WormholeU64Interface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<WormholeU64Interface, byte_ordered_key<KEY_TYPE> && numeric_key<KEY_TYPE> && word_payload<PAYLOAD_TYPE>>(index, index_type);
   }
   else if( index_type == "hot") {
-    index = new HotInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<HotInterface, byte_ordered_key<KEY_TYPE>>(index, index_type);
   }
   else if( index_type == "hotrowex") {
-    index = new HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<HotRowexInterface, byte_ordered_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "masstree") {
-    index = new MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<MasstreeInterface, byte_ordered_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "xindex") {
-    index = new xindexInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<xindexInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "pgm") {
-    index = new pgmInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<pgmInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else if(index_type == "btree") {
-    index = new BTreeInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<BTreeInterface, true>(index, index_type);
   }
   else if (index_type == "artolc") {
-    index = new ARTOLCInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<ARTOLCInterface, byte_ordered_key<KEY_TYPE>>(index, index_type);
   }
   // else if (index_type == "artrowex") {
   //   index = new ARTROWEXInterface<KEY_TYPE, PAYLOAD_TYPE>;
   // }
   else if (index_type == "artunsync") {
-    index = new ARTUnsynchronizedInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<ARTUnsynchronizedInterface, byte_ordered_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "lippol") {
-    index = new LIPPOLInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<LIPPOLInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "lipp") {
-    index = new LIPPInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<LIPPInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else if (index_type == "finedex") {
-    index = new finedexInterface<KEY_TYPE, PAYLOAD_TYPE>;
+    make_index<finedexInterface, numeric_key<KEY_TYPE>>(index, index_type);
   }
   else {
     std::cout << "Could not find a matching index called " << index_type << ".\n";
@@ -78,4 +115,62 @@ indexInterface<KEY_TYPE, PAYLOAD_TYPE> *get_index(std::string index_type) {
   }
 
   return index;
-}
\ No newline at end of file
+}
+
+// Call f with index cast to the adapter type named by index_type. The adapters are final, so
+// calls made through the typed pointer are resolved at compile time and can be inlined.
+// Unknown types get the indexInterface pointer back.
+template<class KEY_TYPE, class PAYLOAD_TYPE, class F>
+void dispatch_index(std::string index_type, indexInterface<KEY_TYPE, PAYLOAD_TYPE> *index, F &&f) {
+  if (index_type == "alexol") {
+    cast_index<alexolInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if(index_type == "alex") {
+    cast_index<alexInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "btreeolc") {
+    cast_index<BTreeOLCInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "wormhole") {
+    cast_index<WormholeInterface, byte_ordered_key<KEY_TYPE> && word_payload<PAYLOAD_TYPE>>(index, f);
+  }
+  else if (index_type == "wormhole_u64") {
+    cast_index<WormholeU64Interface, byte_ordered_key<KEY_TYPE> && numeric_key<KEY_TYPE> && word_payload<PAYLOAD_TYPE>>(index, f);
+  }
+  else if( index_type == "hot") {
+    cast_index<HotInterface, byte_ordered_key<KEY_TYPE>>(index, f);
+  }
+  else if( index_type == "hotrowex") {
+    cast_index<HotRowexInterface, byte_ordered_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "masstree") {
+    cast_index<MasstreeInterface, byte_ordered_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "xindex") {
+    cast_index<xindexInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "pgm") {
+    cast_index<pgmInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if(index_type == "btree") {
+    cast_index<BTreeInterface, true>(index, f);
+  }
+  else if (index_type == "artolc") {
+    cast_index<ARTOLCInterface, byte_ordered_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "artunsync") {
+    cast_index<ARTUnsynchronizedInterface, byte_ordered_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "lippol") {
+    cast_index<LIPPOLInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "lipp") {
+    cast_index<LIPPInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else if (index_type == "finedex") {
+    cast_index<finedexInterface, numeric_key<KEY_TYPE>>(index, f);
+  }
+  else {
+    f(index);
+  }
+}
@@ -3,7 +3,7 @@
 #include"../indexInterface.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class finedexInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class finedexInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   void init(Param *param = nullptr) {}
 
@@ -82,5 +82,6 @@ size_t finedexInterface<KEY_TYPE, PAYLOAD_TYPE>::scan(KEY_TYPE key_low_bound, si
   std::vector<std::pair<KEY_TYPE, PAYLOAD_TYPE>> res;
   res.reserve(key_num);
   size_t scan_size = index.scan(key_low_bound, key_num, res);
+  std::copy(res.begin(), res.begin() + std::min(res.size(), key_num), result);
   return scan_size;
 }
\ No newline at end of file
@@ -1,5 +1,5 @@
 #include <hot/singlethreaded/HOTSingleThreaded.hpp>
-#include <idx/contenthelpers/PairPointerKeyExtractor.hpp>
+#include "key_extractor.h"
 #include <algorithm>
 #include <random>
 #include"../indexInterface.h"
@@ -8,11 +8,11 @@
 #include<cstdio>
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class HotInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class HotInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   HotInterface() {
     idx = new hot::singlethreaded::HOTSingleThreaded < std::pair < KEY_TYPE, PAYLOAD_TYPE > *,
-      idx::contenthelpers::PairPointerKeyExtractor > ();
+      PairPointerHotKeyExtractor > ();
     return;
   }
 
@@ -41,7 +41,7 @@ public:
 
 private:
   std::vector <std::pair<KEY_TYPE, PAYLOAD_TYPE>> data;
-  hot::singlethreaded::HOTSingleThreaded<std::pair < KEY_TYPE, PAYLOAD_TYPE>*, idx::contenthelpers::PairPointerKeyExtractor> *
+  hot::singlethreaded::HOTSingleThreaded<std::pair < KEY_TYPE, PAYLOAD_TYPE>*, PairPointerHotKeyExtractor> *
   idx;
 };
 
@@ -50,16 +50,17 @@ void HotInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYPE, PAYLOA
                                                      Param *param) {
   std::random_device rd;
   std::mt19937 gen(rd());
+  // the index points to its own copies of the pairs, which update overwrites
+  data.assign(key_value, key_value + num);
   for (auto i = 0; i < num; i++) {
-    idx->upsert(&(key_value[i]));
+    idx->upsert(&(data[i]));
   }
-  data.reserve(num);
   //hot::singlethreaded::hot_stat.clear();
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
-  auto result = idx->lookup(key);
+  auto result = idx->lookup(hot_key(key));
   if (result.mIsValid) {
     val = result.mValue->second;
     return true;
@@ -76,19 +77,26 @@ bool HotInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value,
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
+  // the key of a pair never changes, so the payload is overwritten in place
+  auto result = idx->lookup(hot_key(key));
+  if (result.mIsValid) {
+    result.mValue->second = value;
+    return true;
+  } else {
     return false;
+  }
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotInterface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
-  return idx->remove(key);
+  return idx->remove(hot_key(key));
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 size_t HotInterface<KEY_TYPE, PAYLOAD_TYPE>::scan(KEY_TYPE key_low_bound, size_t key_num,
                                                   std::pair<KEY_TYPE, PAYLOAD_TYPE> *result,
                                                   Param *param) {
-  auto iterator = idx->lower_bound(key_low_bound);
+  auto iterator = idx->lower_bound(hot_key(key_low_bound));
   PAYLOAD_TYPE accumulator = 0;
   size_t num;
   for (num = 0u;
@@ -1,5 +1,5 @@
 #include <hot/rowex/HOTRowex.hpp>
-#include <idx/contenthelpers/PairPointerKeyExtractor.hpp>
+#include "key_extractor.h"
 #include <algorithm>
 #include <random>
 #include"../indexInterface.h"
@@ -7,12 +7,51 @@
 #include <hot/rowex/HOTRowexIterator.hpp>
 #include<cstdio>
 
+// The record a HOT-ROWEX entry points to. HOT-ROWEX has no remove and no way to free a record
+// that readers may still hold, so a record stays in the index once inserted: update writes its
+// payload in place, remove marks it removed and a later put of the key revives it. Payload words
+// and the flag are accessed atomically, so concurrent readers see every word either before or
+// after a write, and a payload written before the record is revived.
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class HotRowexInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+struct HotRowexRecord : std::pair<KEY_TYPE, PAYLOAD_TYPE> {
+  static_assert(sizeof(PAYLOAD_TYPE) % sizeof(uint64_t) == 0, "payloads are whole words");
+
+  bool removed = false;
+
+  HotRowexRecord(KEY_TYPE key, PAYLOAD_TYPE value) : std::pair<KEY_TYPE, PAYLOAD_TYPE>(key, value) {}
+
+  bool live() const { return !__atomic_load_n(&removed, __ATOMIC_ACQUIRE); }
+
+  // flips removed from !to to to, false if another thread got there first
+  bool mark(bool to) {
+    bool expected = !to;
+    return __atomic_compare_exchange_n(&removed, &expected, to, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+  }
+
+  PAYLOAD_TYPE load() const {
+    PAYLOAD_TYPE value;
+    auto *src = reinterpret_cast<const uint64_t *>(&this->second);
+    auto *dst = reinterpret_cast<uint64_t *>(&value);
+    for (size_t i = 0; i < sizeof(PAYLOAD_TYPE) / sizeof(uint64_t); i++) {
+      dst[i] = __atomic_load_n(src + i, __ATOMIC_RELAXED);
+    }
+    return value;
+  }
+
+  void store(const PAYLOAD_TYPE &value) {
+    auto *src = reinterpret_cast<const uint64_t *>(&value);
+    auto *dst = reinterpret_cast<uint64_t *>(&this->second);
+    for (size_t i = 0; i < sizeof(PAYLOAD_TYPE) / sizeof(uint64_t); i++) {
+      __atomic_store_n(dst + i, src[i], __ATOMIC_RELAXED);
+    }
+  }
+};
+
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+class HotRowexInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   HotRowexInterface() {
-    idx = new hot::rowex::HOTRowex < std::pair < KEY_TYPE, PAYLOAD_TYPE > *,
-      idx::contenthelpers::PairPointerKeyExtractor > ();
+    idx = new hot::rowex::HOTRowex<Record *, PairPointerHotKeyExtractor>();
     return;
   }
 
@@ -40,9 +79,10 @@ public:
   }
 
 private:
-  std::vector <std::pair<KEY_TYPE, PAYLOAD_TYPE>> data;
-  hot::rowex::HOTRowex<std::pair < KEY_TYPE, PAYLOAD_TYPE>*, idx::contenthelpers::PairPointerKeyExtractor> *
-  idx;
+  typedef HotRowexRecord<KEY_TYPE, PAYLOAD_TYPE> Record;
+
+  std::vector<Record> data;
+  hot::rowex::HOTRowex<Record *, PairPointerHotKeyExtractor> *idx;
 };
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
@@ -50,17 +90,21 @@ void HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYPE, P
                                                      Param *param) {
   std::random_device rd;
   std::mt19937 gen(rd());
+  // the index points to records of its own, which update and remove write
+  data.reserve(num);
   for (auto i = 0; i < num; i++) {
-    idx->upsert(&(key_value[i]));
+    data.emplace_back(key_value[i].first, key_value[i].second);
+  }
+  for (auto i = 0; i < num; i++) {
+    idx->upsert(&(data[i]));
   }
-  data.reserve(num);
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
-  auto result = idx->lookup(key);
-  if (result.mIsValid) {
-    val = result.mValue->second;
+  auto result = idx->lookup(hot_key(key));
+  if (result.mIsValid && result.mValue->live()) {
+    val = result.mValue->load();
     return true;
   } else {
     return false;
@@ -69,33 +113,44 @@ bool HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-  auto val = new std::pair<KEY_TYPE, PAYLOAD_TYPE>(key, value);
-  return idx->insert(val);;
+  auto val = new Record(key, value);
+  if (idx->insert(val)) return true;
+  delete val;
+  // the key has a record already, which the put revives if it was removed
+  auto result = idx->lookup(hot_key(key));
+  if (!result.mIsValid || result.mValue->live()) return false;
+  result.mValue->store(value);
+  return result.mValue->mark(false);
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
+  auto result = idx->lookup(hot_key(key));
+  if (result.mIsValid && result.mValue->live()) {
+    result.mValue->store(value);
+    return true;
+  } else {
     return false;
+  }
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
-  printf("HOT doesn't support remove!");
-  exit(0);
-  return true;
+  auto result = idx->lookup(hot_key(key));
+  return result.mIsValid && result.mValue->mark(true);
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 size_t HotRowexInterface<KEY_TYPE, PAYLOAD_TYPE>::scan(KEY_TYPE key_low_bound, size_t key_num,
                                                   std::pair<KEY_TYPE, PAYLOAD_TYPE> *result,
                                                   Param *param) {
-  auto iterator = idx->lower_bound(key_low_bound);
+  auto iterator = idx->lower_bound(hot_key(key_low_bound));
   PAYLOAD_TYPE accumulator = 0;
   size_t num;
   //for (num = 0u; num < key_num && iterator != hot::rowex::HOTRowexSynchronizedIterator < std::pair < KEY_TYPE, PAYLOAD_TYPE > *, idx::contenthelpers::PairPointerKeyExtractor > ::end(); ++num) {
-  for (num = 0u; num < key_num && iterator != iterator.end(); ++num) {
-    result[num] = {(*(iterator))->first,(*(iterator))->second};
-    ++iterator;
+  for (num = 0u; num < key_num && iterator != iterator.end(); ++iterator) {
+    // removed records stay in the index and are skipped
+    if ((*iterator)->live()) result[num++] = {(*iterator)->first, (*iterator)->load()};
   }
   return num;
 }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include "../../benchmark/string_key.h"
+
+// HOT indexes the pair pointers by the key their extractor returns: integer keys as they are,
+// string keys as their NUL-terminated characters
+inline const char *hot_key(const StringKey &key) { return key.data; }
+
+template<class KEY_TYPE>
+inline KEY_TYPE hot_key(KEY_TYPE key) { return key; }
+
+template<typename PairPointerType>
+struct PairPointerHotKeyExtractor {
+  typedef typename std::remove_pointer<PairPointerType>::type PairType;
+  typedef decltype(hot_key(std::declval<const typename PairType::first_type &>())) KeyType;
+
+  inline KeyType operator()(PairPointerType const &value) const {
+    return hot_key(value->first);
+  }
+};
@@ -1,10 +1,13 @@
 #include <iomanip>
+#include "../benchmark/interleave.h"
+#include "../benchmark/string_key.h"
 
 #pragma once
 
 struct Param { // for xindex
   size_t worker_num;
   uint32_t thread_id;
+  void *context = nullptr; // per-thread state of the index, see register_thread
 
   Param(size_t worker_num, uint32_t thread_id) : worker_num(worker_num), thread_id(thread_id) {}
 };
@@ -26,6 +29,31 @@ public:
 
   virtual bool get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param = nullptr) = 0;
 
+  // Look up num independent keys, found[i] tells whether vals[i] was filled. Returns the
+  // number of keys found. Indexes override this to overlap the cache misses of the lookups.
+  virtual size_t multi_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found,
+                           Param *param = nullptr) {
+    size_t found_num = 0;
+    for (size_t i = 0; i < num; i++) {
+      found[i] = get(keys[i], vals[i], param);
+      found_num += found[i];
+    }
+    return found_num;
+  }
+
+  // Look up num keys with up to group lookups in flight at once, each one a resumable task
+  // run by run_interleaved that yields at its likely cache misses. Indexes without such a
+  // lookup path run them one after another.
+  virtual size_t interleaved_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found,
+                                 size_t group, Param *param = nullptr) {
+    size_t found_num = 0;
+    for (size_t i = 0; i < num; i++) {
+      found[i] = get(keys[i], vals[i], param);
+      found_num += found[i];
+    }
+    return found_num;
+  }
+
   virtual bool put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr) = 0;
 
   virtual bool update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr) = 0;
@@ -37,5 +65,28 @@ public:
 
   virtual void init(Param *param = nullptr) = 0;
 
+  // Whether update, remove and scan do their work. An index leaves one out by overriding it
+  // to return false, and the benchmark then refuses workloads that would time it as a no-op.
+  virtual bool supports_update() { return true; }
+
+  virtual bool supports_remove() { return true; }
+
+  virtual bool supports_scan() { return true; }
+
+  // Every thread calls register_thread before its first operation on the index and
+  // unregister_thread after its last one, with the Param it passes to the operations in
+  // between. Indexes with per-thread state (thread info, epoch or reclamation handles) set it
+  // up here once and keep it in param->context instead of looking it up on every operation.
+  virtual void register_thread(Param *param) {}
+
+  virtual void unregister_thread(Param *param) {}
+
+  // A registered thread parks before it waits for the other threads (warmup done, barrier)
+  // and resumes before its next operation, so that state it holds for reclamation (a QSBR
+  // reader, an epoch) does not hold up the threads that are still running.
+  virtual void park_thread(Param *param) {}
+
+  virtual void resume_thread(Param *param) {}
+
   virtual long long memory_consumption() = 0; // bytes
 };
\ No newline at end of file
@@ -2,7 +2,7 @@
 #include"../indexInterface.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class LIPPOLInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class LIPPOLInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
     void init(Param *param = nullptr) {}
 
@@ -56,9 +56,8 @@ template<class KEY_TYPE, class PAYLOAD_TYPE>
 size_t LIPPOLInterface<KEY_TYPE, PAYLOAD_TYPE>::scan(KEY_TYPE key_low_bound, size_t key_num,
                                                    std::pair <KEY_TYPE, PAYLOAD_TYPE> *result,
                                                    Param *param) {
-    // if(!result) {
-    //     result = new std::pair <KEY_TYPE, PAYLOAD_TYPE>[key_num];
-    // }
-    // return lipp.range_query_len(result, key_low_bound, key_num);
-    return 0;
+    if(!result) {
+        result = new std::pair <KEY_TYPE, PAYLOAD_TYPE>[key_num];
+    }
+    return lipp.range_query_len(result, key_low_bound, key_num);
 }
\ No newline at end of file
@@ -1,39 +1,37 @@
 #include"./src/mtIndexAPI.hh"
 #include "./src/config.h"
 #include"../indexInterface.h"
+#include <mutex>
+#include <vector>
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class MasstreeInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class MasstreeInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   typedef mt_index<Masstree::default_table> MapType;
 
   MasstreeInterface() {
     idx = new MapType{};
 
-    ti[0].instance = threadinfo::make(threadinfo::TI_MAIN, -1);
-    idx->setup(ti[0].instance);
+    main_ti = threadinfo::make(threadinfo::TI_MAIN, -1);
+    idx->setup(main_ti);
   }
 
-  void init(Param *param = nullptr) {
-    thread_num = param->worker_num;
-    for (int i = 1; i < thread_num; i++) {
-      ti[i].instance = threadinfo::make(threadinfo::TI_MAIN, -1);
-    }
+  void init(Param *param = nullptr) {}
+
+  // Every thread id gets a threadinfo of its own when it first registers and keeps it for the
+  // next phases, Masstree cannot free one.
+  void register_thread(Param *param) {
+    std::lock_guard<std::mutex> lock(ti_mutex);
+    if (thread_infos.size() <= param->thread_id) thread_infos.resize(param->thread_id + 1, nullptr);
+    auto &ti = thread_infos[param->thread_id];
+    if (!ti) ti = threadinfo::make(threadinfo::TI_MAIN, -1);
+    param->context = ti;
   }
 
-  // inline void swap_endian(uint64_t &i) {
-  //   // Note that masstree internally treat input as big-endian
-  //   // integer values, so we need to swap here
-  //   // This should be just one instruction
-  //   i = __bswap_64(i);
-  // }
+  void unregister_thread(Param *param) { param->context = nullptr; }
 
-  inline void swap_endian(uint32_t &i) {
-    i = __builtin_bswap32(i);
-  }
-  inline void swap_endian(uint64_t &i) {
-    i = __builtin_bswap64(i);
-  }
+  // Masstree compares keys as byte strings, so keys are passed as their KeyBytes:
+  // integers big-endian, string keys as their characters
 
   void bulk_load(std::pair<KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num, Param *param = nullptr);
 
@@ -46,7 +44,7 @@ public:
   bool remove(KEY_TYPE key, Param *param = nullptr);
 
   size_t scan(KEY_TYPE key_low_bound, size_t key_num, std::pair<KEY_TYPE, PAYLOAD_TYPE> *result,
-              Param *param = nullptr) { return 0; }
+              Param *param = nullptr);
 
   ~MasstreeInterface() {
     if (idx) {
@@ -57,32 +55,37 @@ public:
   long long memory_consumption() { return 0; }
 
 private:
+  // the threadinfo of the calling thread: the one of its thread id once registered, else one
+  // of its own, so that no two threads ever share one
+  threadinfo *thread_info(Param *param) {
+    if (param && param->context) return static_cast<threadinfo *>(param->context);
+    thread_local threadinfo *ti = threadinfo::make(threadinfo::TI_MAIN, -1);
+    return ti;
+  }
+
   MapType *idx;
-  struct alignas(CACHELINE_SIZE) threadinfo_align {
-        struct threadinfo *instance;
-  };
-  struct threadinfo_align ti[256];
-  size_t thread_num;
+  threadinfo *main_ti;
+  std::vector<threadinfo *> thread_infos;
+  std::mutex ti_mutex;
 };
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 void MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair<KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num,
                                                           Param *param) {
   for (auto i = 0; i < num; i++) {
-    auto key = key_value[i].first;
+    KeyBytes<KEY_TYPE> key(key_value[i].first);
     auto value = key_value[i].second;
-    swap_endian(key);
-    idx->put_uv((const char *) &key, sizeof(KEY_TYPE), (const char *) &value, sizeof(PAYLOAD_TYPE), ti[param->thread_id].instance);
+    idx->put_uv(key.data(), key.size(), (const char *) &value, sizeof(PAYLOAD_TYPE), thread_info(param));
   }
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
   Str v;
-  swap_endian(key);
-  idx->get((const char *) &key, sizeof(KEY_TYPE), v, ti[param->thread_id].instance);
+  KeyBytes<KEY_TYPE> bytes(key);
+  idx->get(bytes.data(), bytes.size(), v, thread_info(param));
   if (v.s) {
-    val = static_cast<PAYLOAD_TYPE>(*(uint64_t *) v.s);
+    memcpy(&val, v.s, sizeof(PAYLOAD_TYPE));
     return true;
   } else {
     return false;
@@ -91,21 +94,34 @@ bool MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-  swap_endian(key);
-  idx->put_uv((const char *) &key, sizeof(KEY_TYPE), (const char *) &value, 8, ti[param->thread_id].instance);
+  KeyBytes<KEY_TYPE> bytes(key);
+  idx->put_uv(bytes.data(), bytes.size(), (const char *) &value, sizeof(PAYLOAD_TYPE), thread_info(param));
   return true;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-  swap_endian(key);
-  idx->put((const char *) &key, sizeof(KEY_TYPE), (const char *) &value, 8, ti[param->thread_id].instance);
+  KeyBytes<KEY_TYPE> bytes(key);
+  idx->put(bytes.data(), bytes.size(), (const char *) &value, sizeof(PAYLOAD_TYPE), thread_info(param));
   return true;
 }
 
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+size_t MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::scan(KEY_TYPE key_low_bound, size_t key_num,
+                                                       std::pair<KEY_TYPE, PAYLOAD_TYPE> *result, Param *param) {
+  KeyBytes<KEY_TYPE> bytes(key_low_bound);
+  size_t count = 0;
+  idx->scan(bytes.data(), bytes.size(), static_cast<int>(key_num), [&](Str key, Str value) {
+    result[count].first = key_from_bytes<KEY_TYPE>(key.s, key.len);
+    memcpy(&result[count].second, value.s, sizeof(PAYLOAD_TYPE));
+    count++;
+  }, thread_info(param));
+  return count;
+}
+
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool MasstreeInterface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
-//  index.erase(key);
-  return true;
+  KeyBytes<KEY_TYPE> bytes(key);
+  return idx->remove(bytes.data(), bytes.size(), thread_info(param));
 }
 
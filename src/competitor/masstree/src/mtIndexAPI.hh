@@ -167,6 +167,22 @@ public:
     put(Str(key, keylen), Str(value, valuelen), ti);
   }
 
+  //#################################################################################
+  // Remove
+  //#################################################################################
+  inline bool remove(const Str &key, threadinfo *ti) {
+    typename T::cursor_type lp(table_->table(), key);
+    bool found = lp.find_locked(*ti);
+    if (found)
+      lp.value()->deallocate_rcu(*ti);
+    lp.finish(-1, *ti);
+    return found;
+  }
+
+  bool remove(const char *key, int keylen, threadinfo *ti) {
+    return remove(Str(key, keylen), ti);
+  }
+
   //#################################################################################
   // Get (unique value)
   //#################################################################################
@@ -232,6 +248,35 @@ public:
     return count;
   }
 
+  //#################################################################################
+  // Scan: pass up to range key/value pairs from key on to f, in key order
+  //#################################################################################
+  template <typename F>
+  struct pair_scanner {
+    F &f;
+    int range;
+
+    pair_scanner(F &f, int range)
+      : f(f), range(range) {
+    }
+
+    template <typename SS2, typename K2>
+    void visit_leaf(const SS2&, const K2&, threadinfo&) {}
+    bool visit_value(Str key, const row_type* row, threadinfo&) {
+        f(key, row->col(0));
+        --range;
+        return range > 0;
+    }
+  };
+  template <typename F>
+  int scan(const char *key, int keylen, int range, F &&f, threadinfo *ti) {
+    if (range == 0)
+      return 0;
+
+    pair_scanner<F> s(f, range);
+    return table_->table().scan(Str(key, keylen), true, s, *ti);
+  }
+
 private:
   T *table_;
   query<row_type> q_[1];
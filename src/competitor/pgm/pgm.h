@@ -1,8 +1,76 @@
 #include"./src/include/pgm/pgm_index_dynamic.hpp"
 #include"../indexInterface.h"
+#include <algorithm>
+#include <type_traits>
 
+// DynamicPGMIndex with a batched find that searches each level for every key of the batch
+// before it moves on to the next level: the PGM predictions of all the keys are made and their
+// items prefetched before the last-mile searches. It reaches the levels as a subclass, and where
+// the library keeps them private levels_visible() is false and lookups go one key at a time.
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class pgmInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class BatchedDynamicPGMIndex : public pgm::DynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE> {
+  template<class S, class = void>
+  struct reachable : std::false_type {};
+
+  template<class S>
+  struct reachable<S, std::void_t<decltype(std::declval<const S &>().level(0).begin()->deleted()),
+                                  decltype(std::declval<const S &>().pgm(0).search(std::declval<KEY_TYPE>()).lo),
+                                  decltype(std::declval<const S &>().min_level),
+                                  decltype(std::declval<const S &>().min_index_level),
+                                  decltype(std::declval<const S &>().used_levels)>> : std::true_type {};
+
+public:
+  using pgm::DynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE>::DynamicPGMIndex;
+
+  static constexpr bool levels_visible() { return reachable<BatchedDynamicPGMIndex>::value; }
+
+  // find of num keys, found[i] tells whether vals[i] was filled; only if levels_visible()
+  size_t multi_find(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found) const {
+    constexpr size_t batch = 32;
+    size_t lo[batch], hi[batch];
+    bool done[batch];
+    size_t found_num = 0;
+    for (size_t begin = 0; begin < num; begin += batch) {
+      size_t n = std::min(batch, num - begin);
+      std::fill(done, done + n, false);
+      // the levels in the order find searches them, so the first match is the newest entry
+      for (auto i = this->min_level; i < this->used_levels; ++i) {
+        const auto &items = this->level(i);
+        if (items.empty()) continue;
+        for (size_t j = 0; j < n; j++) {
+          if (done[j]) continue;
+          lo[j] = 0;
+          hi[j] = items.size();
+          if (i >= this->min_index_level) {
+            auto range = this->pgm(i).search(keys[begin + j]);
+            lo[j] = range.lo;
+            hi[j] = range.hi;
+          }
+          __builtin_prefetch(&*(items.begin() + (lo[j] + hi[j]) / 2));
+        }
+        for (size_t j = 0; j < n; j++) {
+          if (done[j]) continue;
+          auto it = std::lower_bound(items.begin() + lo[j], items.begin() + hi[j], keys[begin + j]);
+          if (it != items.end() && it->first == keys[begin + j]) {
+            done[j] = true;
+            found[begin + j] = !it->deleted();
+            if (found[begin + j]) {
+              vals[begin + j] = it->second;
+              found_num++;
+            }
+          }
+        }
+      }
+      for (size_t j = 0; j < n; j++) {
+        if (!done[j]) found[begin + j] = false;
+      }
+    }
+    return found_num;
+  }
+};
+
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+class pgmInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
   void init(Param *param = nullptr) {}
 
@@ -10,6 +78,14 @@ public:
 
   bool get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param = nullptr);
 
+  size_t multi_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found, Param *param = nullptr) {
+    if constexpr (BatchedDynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE>::levels_visible()) {
+      return index->multi_find(keys, num, vals, found);
+    } else {
+      return indexInterface<KEY_TYPE, PAYLOAD_TYPE>::multi_get(keys, num, vals, found, param);
+    }
+  }
+
   bool put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
 
   bool update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
@@ -22,13 +98,13 @@ public:
   long long memory_consumption() { return index->size_in_bytes(); }
 
 private:
-  pgm::DynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE> *index;
+  BatchedDynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE> *index;
 };
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 void pgmInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num,
                                                      Param *param) {
-  index = new pgm::DynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE>(key_value, key_value + num);
+  index = new BatchedDynamicPGMIndex<KEY_TYPE, PAYLOAD_TYPE>(key_value, key_value + num);
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
@@ -5,7 +5,7 @@
 #include "omp.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class WormholeInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class WormholeInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
 
   WormholeInterface() {
@@ -25,24 +25,26 @@ public:
 
   bool put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
 
+  bool update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
+
   bool remove(KEY_TYPE key, Param *param = nullptr);
 
   size_t scan(KEY_TYPE key_low_bound, size_t key_num,  std::pair<KEY_TYPE, PAYLOAD_TYPE> *result,
               Param *param = nullptr) {
     auto iter = wh_iter_create(ref[param->thread_id].instance);
-    auto key_rev = __builtin_bswap64(key_low_bound);
-    wh_iter_seek(iter, &key_rev, sizeof(KEY_TYPE));
+    KeyBytes<KEY_TYPE> low(key_low_bound);
+    wh_iter_seek(iter, low.data(), low.size());
     size_t scan_num = key_num;
     for (int i = 0; i < key_num; i++) {
       if(!wh_iter_valid(iter)) {
-        scan_num = i + 1;
+        scan_num = i;
         break;
       }
       uint64_t val;
-      uint64_t key;
+      char key[sizeof(KEY_TYPE)];
       u32 key_len, val_len;
-      wh_iter_peek(iter, (char *) &key, sizeof(KEY_TYPE), &key_len, (char *) &val, sizeof(PAYLOAD_TYPE), &val_len);
-      result[i] = {__builtin_bswap64(key), __builtin_bswap64(val)};
+      wh_iter_peek(iter, key, sizeof(key), &key_len, (char *) &val, sizeof(PAYLOAD_TYPE), &val_len);
+      result[i] = {key_from_bytes<KEY_TYPE>(key, key_len), __builtin_bswap64(val)};
       wh_iter_skip1(iter);
     }
     wh_iter_destroy(iter);
@@ -71,18 +73,18 @@ template<class KEY_TYPE, class PAYLOAD_TYPE>
 void WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num, Param *param) {
 // #pragma omp parallel for
   for (auto i = 0; i < num; i++) {
-    auto key = __builtin_bswap64(key_value[i].first);
+    KeyBytes<KEY_TYPE> key(key_value[i].first);
     auto value = __builtin_bswap64(key_value[i].second);
-    wh_put(this->ref[param->thread_id].instance, &key, sizeof(KEY_TYPE), &value, sizeof(PAYLOAD_TYPE));
+    wh_put(this->ref[param->thread_id].instance, key.data(), key.size(), &value, sizeof(PAYLOAD_TYPE));
   }
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
   u32 len_val;
-  uint64_t rev_key = __builtin_bswap64(key);
+  KeyBytes<KEY_TYPE> bytes(key);
   uint64_t rev_val;
-  auto ret = wh_get(ref[param->thread_id].instance, &rev_key, sizeof(KEY_TYPE), &rev_val, sizeof(PAYLOAD_TYPE), &len_val);
+  auto ret = wh_get(ref[param->thread_id].instance, bytes.data(), bytes.size(), &rev_val, sizeof(PAYLOAD_TYPE), &len_val);
   if (ret) {
     val = __builtin_bswap64(rev_val);
     return true;
@@ -93,13 +95,23 @@ bool WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-  uint64_t rev_key = __builtin_bswap64(key);
+  KeyBytes<KEY_TYPE> bytes(key);
+  uint64_t rev_val = __builtin_bswap64(value);
+  return wh_put(ref[param->thread_id].instance, bytes.data(), bytes.size(), &rev_val, sizeof(PAYLOAD_TYPE));
+}
+
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+bool WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
+  // a put of a key that is there; a remove between the probe and the put is not detected
+  KeyBytes<KEY_TYPE> bytes(key);
+  auto instance = ref[param->thread_id].instance;
+  if (!wh_probe(instance, bytes.data(), bytes.size())) return false;
   uint64_t rev_val = __builtin_bswap64(value);
-  return wh_put(ref[param->thread_id].instance, &rev_key, sizeof(KEY_TYPE), &rev_val, sizeof(PAYLOAD_TYPE));
+  return wh_put(instance, bytes.data(), bytes.size(), &rev_val, sizeof(PAYLOAD_TYPE));
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeInterface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
-//  index.erase(key);
-  return false;
+  KeyBytes<KEY_TYPE> bytes(key);
+  return wh_del(ref[param->thread_id].instance, bytes.data(), bytes.size());
 }
@@ -5,18 +5,33 @@
 #include "omp.h"
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class WormholeU64Interface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class WormholeU64Interface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
 
     WormholeU64Interface() {
         wh = wormhole_u64_create(&mm_nnn); 
     }
 
-    void init(Param *param = nullptr) {
-        // this->thread_num = param->worker_num;
-        // for (int i = 0; i < thread_num; i++) {
-            // ref[i].instance = wormhole_ref(wh);
-        // }
+    void init(Param *param = nullptr) {}
+
+    // A registered thread keeps one wormref, a QSBR reader of the wormhole, for all its
+    // operations. It parks the ref while it waits for the other threads, so that writers
+    // resizing the table do not wait for it.
+    void register_thread(Param *param) {
+        param->context = wormhole_ref(wh);
+    }
+
+    void unregister_thread(Param *param) {
+        wormhole_unref(static_cast<struct wormref *>(param->context));
+        param->context = nullptr;
+    }
+
+    void park_thread(Param *param) {
+        wormhole_park(static_cast<struct wormref *>(param->context));
+    }
+
+    void resume_thread(Param *param) {
+        wormhole_resume(static_cast<struct wormref *>(param->context));
     }
 
     void bulk_load(std::pair <KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num, Param *param = nullptr);
@@ -31,89 +46,87 @@ public:
 
     size_t scan(KEY_TYPE key_low_bound, size_t key_num, std::pair <KEY_TYPE, PAYLOAD_TYPE> *result,
                 Param *param = nullptr) {
-        // auto iter = wh_iter_create(ref[param->thread_id].instance);
-        // auto key_rev = __builtin_bswap64(key_low_bound);
-        // wh_iter_seek(iter, &key_rev, sizeof(KEY_TYPE));
-        // size_t scan_num = key_num;
-        // for (int i = 0; i < key_num; i++) {
-        //   if(!wh_iter_valid(iter)) {
-        //     scan_num = i + 1;
-        //     break;
-        //   }
-        //   uint64_t val;
-        //   uint64_t key;
-        //   u32 key_len, val_len;
-        //   wh_iter_peek(iter, (char *) &key, sizeof(KEY_TYPE), &key_len, (char *) &val, sizeof(PAYLOAD_TYPE), &val_len);
-        //   result[i] = {__builtin_bswap64(key), __builtin_bswap64(val)};
-        //   wh_iter_skip1(iter);
-        // }
-        // wh_iter_destroy(iter);
-        // return scan_num;
-        return 0;
+        // the wormhole orders keys as bytes, so the u64 keys are stored big-endian
+        struct wormref * const ref = acquire(param);
+        struct wormhole_iter * const iter = wh_iter_create(ref);
+        const u64 key_rev = __builtin_bswap64(key_low_bound);
+        wh_iter_seek(iter, &key_rev, sizeof(KEY_TYPE));
+        size_t scan_num = 0;
+        while (scan_num < key_num && wh_iter_valid(iter)) {
+            u64 key;
+            u64 val;
+            u32 key_len, val_len;
+            wh_iter_peek(iter, &key, sizeof(KEY_TYPE), &key_len, &val, sizeof(PAYLOAD_TYPE), &val_len);
+            result[scan_num++] = {__builtin_bswap64(key), (PAYLOAD_TYPE) val};
+            wh_iter_skip1(iter);
+        }
+        wh_iter_destroy(iter);
+        release(ref, param);
+        return scan_num;
     }
 
     ~WormholeU64Interface() {
-        // for (int i = 0; i < thread_num; i++) {
-        //     wormhole_unref(ref[i].instance);
-        // }
         wormhole_u64_destroy(wh);
     }
 
     long long memory_consumption() { return 0; }
 
 private:
+    // the wormref of the calling thread from register_thread, or one for a single operation
+    struct wormref *acquire(Param *param) {
+        return param && param->context ? static_cast<struct wormref *>(param->context) : wormhole_ref(wh);
+    }
+
+    void release(struct wormref *ref, Param *param) {
+        if (!(param && param->context)) wormhole_unref(ref);
+    }
+
     const struct kvmap_mm mm_nnn = {kvmap_mm_in_noop, kvmap_mm_out_noop, kvmap_mm_free_noop, NULL};
     struct wormhole *wh;
-    // struct alignas(CACHELINE_SIZE)
-    // wormref_align {
-    //     struct wormref *instance;
-    // };
-    // struct wormref_align ref[256];
-    // size_t thread_num;
 };
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 void WormholeU64Interface<KEY_TYPE, PAYLOAD_TYPE>::bulk_load(std::pair <KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num,Param *param) {
 // #pragma omp parallel for
-    struct wormref * const ref = wormhole_ref(wh);
+    struct wormref * const ref = acquire(param);
     for (auto i = 0; i < num; i++) {
         wormhole_u64_set(ref, key_value[i].first, (void *)key_value[i].second);
     }
-    wormhole_unref(ref);
+    release(ref, param);
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeU64Interface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param) {
-    struct wormref * const ref = wormhole_ref(wh);
+    struct wormref * const ref = acquire(param);
     if(!wormhole_u64_probe(ref, key)) {
-        wormhole_unref(ref);
+        release(ref, param);
         return false;
     }
     val = (PAYLOAD_TYPE)wormhole_u64_get(ref, key, NULL);
-    wormhole_unref(ref);
+    release(ref, param);
     return true;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeU64Interface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-    struct wormref * const ref = wormhole_ref(wh);
+    struct wormref * const ref = acquire(param);
     auto ret = wormhole_u64_set(ref, key, (void *)value);
-    wormhole_unref(ref);
+    release(ref, param);
     return ret;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeU64Interface<KEY_TYPE, PAYLOAD_TYPE>::update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
-    struct wormref * const ref = wormhole_ref(wh);
+    struct wormref * const ref = acquire(param);
     auto ret = wormhole_u64_set(ref, key, (void *)value);
-    wormhole_unref(ref);
+    release(ref, param);
     return ret;
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool WormholeU64Interface<KEY_TYPE, PAYLOAD_TYPE>::remove(KEY_TYPE key, Param *param) {
-    struct wormref * const ref = wormhole_ref(wh);
+    struct wormref * const ref = acquire(param);
     auto ret = wormhole_u64_del(ref, key);
-    wormhole_unref(ref);
+    release(ref, param);
     return ret;
 }
@@ -44,6 +44,15 @@ class XIndex {
   ~XIndex();
 
   inline bool get(const key_t &key, val_t &val, const uint32_t worker_id);
+  inline void multi_get(const key_t *keys, size_t n, val_t *vals, bool *found,
+                        const uint32_t worker_id);
+
+  // resumable get for interleaved execution: call lookup_begin once, then
+  // lookup_step until it returns true, for any number of lookups in flight
+  typedef typename root_t::LookupTask lookup_task_t;
+  inline void lookup_begin(const uint32_t worker_id);
+  inline bool lookup_step(lookup_task_t &task, const key_t &key, val_t &val,
+                          bool &found);
   inline bool put(const key_t &key, const val_t &val, const uint32_t worker_id);
   inline bool remove(const key_t &key, const uint32_t worker_id);
   inline size_t scan(const key_t &begin, const size_t n,
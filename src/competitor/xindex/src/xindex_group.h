@@ -89,6 +89,7 @@ class alignas(CACHELINE_SIZE) Group {
   const key_t &get_pivot();
 
   inline result_t get(const key_t &key, val_t &val);
+  inline void prefetch_array(const key_t &key);
   inline result_t put(const key_t &key, const val_t &val,
                       const uint32_t worker_id);
   inline result_t remove(const key_t &key);
@@ -86,6 +86,16 @@ inline result_t Group<key_t, val_t, seq, max_model_n>::get(const key_t &key,
   return result_t::failed;
 }
 
+// prefetch the predicted array slot of key, used by batched lookups
+template <class key_t, class val_t, bool seq, size_t max_model_n>
+inline void Group<key_t, val_t, seq, max_model_n>::prefetch_array(
+    const key_t &key) {
+  if (array_size == 0) return;
+  size_t pos = models[locate_model(key)].model.predict(key);
+  pos = pos >= array_size ? array_size - 1 : pos;
+  __builtin_prefetch(&data[pos]);
+}
+
 template <class key_t, class val_t, bool seq, size_t max_model_n>
 inline result_t Group<key_t, val_t, seq, max_model_n>::put(
     const key_t &key, const val_t &val, const uint32_t worker_id) {
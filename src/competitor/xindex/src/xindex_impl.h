@@ -70,6 +70,26 @@ inline bool XIndex<key_t, val_t, seq>::get(const key_t &key, val_t &val,
   return root->get(key, val) == result_t::ok;
 }
 
+template <class key_t, class val_t, bool seq>
+inline void XIndex<key_t, val_t, seq>::multi_get(const key_t *keys, size_t n,
+                                                 val_t *vals, bool *found,
+                                                 const uint32_t worker_id) {
+  rcu_progress(worker_id);
+  root->multi_get(keys, n, vals, found);
+}
+
+template <class key_t, class val_t, bool seq>
+inline void XIndex<key_t, val_t, seq>::lookup_begin(const uint32_t worker_id) {
+  rcu_progress(worker_id);
+}
+
+template <class key_t, class val_t, bool seq>
+inline bool XIndex<key_t, val_t, seq>::lookup_step(lookup_task_t &task,
+                                                   const key_t &key, val_t &val,
+                                                   bool &found) {
+  return root->lookup_step(task, key, val, found);
+}
+
 template <class key_t, class val_t, bool seq>
 inline bool XIndex<key_t, val_t, seq>::put(const key_t &key, const val_t &val,
                                            const uint32_t worker_id) {
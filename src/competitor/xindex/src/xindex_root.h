@@ -44,6 +44,15 @@ class Root {
                      double &avg_err);
 
   inline result_t get(const key_t &key, val_t &val);
+  inline void multi_get(const key_t *keys, size_t n, val_t *vals, bool *found);
+
+  // state of a resumable get, see lookup_step
+  struct LookupTask {
+    int stage = 0;
+    group_t *group = nullptr;
+  };
+  inline bool lookup_step(LookupTask &task, const key_t &key, val_t &val,
+                          bool &found);
   inline result_t put(const key_t &key, const val_t &val,
                       const uint32_t worker_id);
   inline result_t remove(const key_t &key);
@@ -194,6 +194,68 @@ inline result_t Root<key_t, val_t, seq>::get(const key_t &key, val_t &val) {
   return locate_group(key)->get(key, val);
 }
 
+// batched get: every stage (group slot, group, data slot) is prefetched for the
+// whole batch before the next stage reads it, so the misses of the keys overlap
+template <class key_t, class val_t, bool seq>
+inline void Root<key_t, val_t, seq>::multi_get(const key_t *keys, size_t n,
+                                               val_t *vals, bool *found) {
+  const size_t batch = 32;
+  group_t *group[batch];
+  for (size_t begin = 0; begin < n; begin += batch) {
+    size_t end = std::min(n, begin + batch);
+    for (size_t i = begin; i < end; i++) {
+      int group_i = predict(keys[i]);
+      group_i = group_i > (int)group_n - 1 ? group_n - 1 : group_i;
+      group_i = group_i < 0 ? 0 : group_i;
+      __builtin_prefetch(&groups[group_i]);
+    }
+    for (size_t i = begin; i < end; i++) {
+      group[i - begin] = locate_group(keys[i]);
+      __builtin_prefetch(group[i - begin]);
+    }
+    for (size_t i = begin; i < end; i++) {
+      group[i - begin]->prefetch_array(keys[i]);
+    }
+    for (size_t i = begin; i < end; i++) {
+      found[i] = group[i - begin]->get(keys[i], vals[i]) == result_t::ok;
+    }
+  }
+}
+
+// get split at its cache misses (group slot, group, data slot) for interleaved
+// execution: each step prefetches what the next one reads and returns false,
+// the last one does the lookup and returns true
+template <class key_t, class val_t, bool seq>
+inline bool Root<key_t, val_t, seq>::lookup_step(LookupTask &task,
+                                                 const key_t &key, val_t &val,
+                                                 bool &found) {
+  switch (task.stage) {
+    case 0: {
+      int group_i = predict(key);
+      group_i = group_i > (int)group_n - 1 ? group_n - 1 : group_i;
+      group_i = group_i < 0 ? 0 : group_i;
+      __builtin_prefetch(&groups[group_i]);
+      task.stage = 1;
+      return false;
+    }
+    case 1: {
+      int group_i;  // unused
+      task.group = locate_group_pt1(key, group_i);
+      __builtin_prefetch(task.group);
+      task.stage = 2;
+      return false;
+    }
+    case 2:
+      task.group = locate_group_pt2(key, task.group);
+      task.group->prefetch_array(key);
+      task.stage = 3;
+      return false;
+    default:
+      found = task.group->get(key, val) == result_t::ok;
+      return true;
+  }
+}
+
 /*
  * Root::put
  */
@@ -1,4 +1,5 @@
 #include <vector>
+#include <algorithm>
 
 #include "./src/xindex.h"
 #include "./src/xindex_impl.h"
@@ -58,12 +59,17 @@ namespace xindex {
 }
 
 template<class KEY_TYPE, class PAYLOAD_TYPE>
-class xindexInterface : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
+class xindexInterface final : public indexInterface<KEY_TYPE, PAYLOAD_TYPE> {
 public:
     void bulk_load(std::pair <KEY_TYPE, PAYLOAD_TYPE> *key_value, size_t num, Param *param);
 
     bool get(KEY_TYPE key, PAYLOAD_TYPE &val, Param *param);
 
+    size_t multi_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found, Param *param);
+
+    size_t interleaved_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals, bool *found, size_t group,
+                           Param *param);
+
     bool put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param);
 
     bool update(KEY_TYPE key, PAYLOAD_TYPE value, Param *param = nullptr);
@@ -136,6 +142,25 @@ bool xindexInterface<KEY_TYPE, PAYLOAD_TYPE>::get(KEY_TYPE key, PAYLOAD_TYPE &va
     return ret;
 }
 
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+size_t xindexInterface<KEY_TYPE, PAYLOAD_TYPE>::multi_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals,
+                                                          bool *found, Param *param) {
+    static_assert(sizeof(xindex::Key<KEY_TYPE>) == sizeof(KEY_TYPE), "xindex::Key must wrap the key only");
+    index->multi_get(reinterpret_cast<const xindex::Key<KEY_TYPE> *>(keys), num, vals, found, param->thread_id);
+    return std::count(found, found + num, true);
+}
+
+template<class KEY_TYPE, class PAYLOAD_TYPE>
+size_t xindexInterface<KEY_TYPE, PAYLOAD_TYPE>::interleaved_get(const KEY_TYPE *keys, size_t num, PAYLOAD_TYPE *vals,
+                                                                bool *found, size_t group, Param *param) {
+    typedef typename std::remove_pointer<decltype(index)>::type::lookup_task_t task_t;
+    index->lookup_begin(param->thread_id);
+    run_interleaved<task_t>(num, group, [&](task_t &task, size_t i) {
+        return index->lookup_step(task, xindex::Key<KEY_TYPE>(keys[i]), vals[i], found[i]);
+    });
+    return std::count(found, found + num, true);
+}
+
 template<class KEY_TYPE, class PAYLOAD_TYPE>
 bool xindexInterface<KEY_TYPE, PAYLOAD_TYPE>::put(KEY_TYPE key, PAYLOAD_TYPE value, Param *param) {
     return index->put(xindex::Key<KEY_TYPE>(key), value, param->thread_id);